@@ -235,6 +235,7 @@ gpib_interface_t agilent_82350b_interface =
 	serial_poll_response: agilent_82350b_serial_poll_response,
 	t1_delay: agilent_82350b_t1_delay,
 	return_to_local: agilent_82350b_return_to_local,
+	direct_io: 1,
 };
 
 int agilent_82350b_allocate_private( gpib_board_t *board )
@@ -358,8 +359,7 @@ int agilent_82350b_generic_attach(gpib_board_t *board, const gpib_board_config_t
 		return -ENOMEM;
 	a_priv = board->private_data;
 	tms_priv = &a_priv->tms9914_priv;
-	tms_priv->read_byte = tms9914_iomem_read_byte;
-	tms_priv->write_byte = tms9914_iomem_write_byte;
+	tms_priv->io_method = TMS9914_IO_MEM;
 	tms_priv->offset = 1;
 
 	// find board
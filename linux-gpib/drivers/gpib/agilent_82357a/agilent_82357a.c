@@ -32,6 +32,28 @@ MODULE_LICENSE("GPL");
 static struct usb_interface *agilent_82357a_driver_interfaces[MAX_NUM_82357A_INTERFACES];
 DEFINE_MUTEX(agilent_82357a_hotplug_lock);
 
+/* The cached ADSR and BSR are dropped by any bus operation we do and SRQ
+ * is fed from the interrupt endpoint, this only bounds how stale lines
+ * changed by other devices can get. */
+static unsigned int status_cache_usec = 10000;
+module_param(status_cache_usec, uint, 0644);
+MODULE_PARM_DESC(status_cache_usec, "microseconds cached status and bus lines are trusted");
+
+static int agilent_82357a_cache_is_fresh(unsigned valid, ktime_t time)
+{
+	return valid && ktime_to_us(ktime_sub(ktime_get(), time)) < status_cache_usec;
+}
+
+static void agilent_82357a_invalidate_status_cache(agilent_82357a_private_t *a_priv)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&a_priv->status_cache_lock, flags);
+	a_priv->adsr_valid = 0;
+	a_priv->bsr_valid = 0;
+	spin_unlock_irqrestore(&a_priv->status_cache_lock, flags);
+}
+
 static void agilent_82357a_bulk_complete(struct urb *urb PT_REGS_ARG)
 {
 	agilent_82357a_urb_context_t *context = urb->context;
@@ -230,6 +252,145 @@ cleanup:
 	return retval;
 }
 
+static void agilent_82357a_consume_read_data(struct agilent_82357a_read_state *state, const uint8_t *data, int length)
+{
+	int i;
+
+	if(length <= 0) return;
+	if(state->have_pending && state->count < state->length)
+		state->buffer[state->count++] = state->pending;
+	for(i = 0; i < length - 1 && state->count < state->length; i++)
+		state->buffer[state->count++] = data[i];
+	if(i < length - 1)
+		printk("%s: %s: bytes_read > length? truncating", __FILE__, __FUNCTION__);
+	state->pending = data[length - 1];
+	state->have_pending = 1;
+}
+
+// submits read urb k for up to the next agilent_82357a_read_buffer_length bytes of the reply
+static int agilent_82357a_submit_read_urb(agilent_82357a_private_t *a_priv, int k, int length,
+	agilent_82357a_urb_context_t *context)
+{
+	struct usb_device *usb_dev;
+	unsigned int in_pipe;
+	int retval;
+
+	if(length > agilent_82357a_read_buffer_length)
+		length = agilent_82357a_read_buffer_length;
+	mutex_lock(&a_priv->bulk_alloc_lock);
+	if(a_priv->bus_interface == NULL)
+	{
+		mutex_unlock(&a_priv->bulk_alloc_lock);
+		return -ENODEV;
+	}
+	usb_dev = interface_to_usbdev(a_priv->bus_interface);
+	in_pipe = usb_rcvbulkpipe(usb_dev, AGILENT_82357_BULK_IN_ENDPOINT);
+	usb_fill_bulk_urb(a_priv->read_urbs[k], usb_dev, in_pipe, a_priv->read_buffers[k], length,
+		&agilent_82357a_bulk_complete, context);
+	retval = usb_submit_urb(a_priv->read_urbs[k], GFP_KERNEL);
+	mutex_unlock(&a_priv->bulk_alloc_lock);
+	if(retval)
+		printk("%s: failed to submit bulk in urb, retval=%i\n", __FILE__, retval);
+	return retval;
+}
+
+/* Receives a read reply of at most reply_length bytes into state, keeping
+ * agilent_82357a_num_read_buffers urbs in flight so the adapter always has
+ * somewhere to put the next packet.  The reply ends with a short packet or
+ * once reply_length bytes have arrived.  Caller must hold bulk_transfer_lock. */
+static int agilent_82357a_receive_bulk_stream(agilent_82357a_private_t *a_priv, struct agilent_82357a_read_state *state,
+	int reply_length, int *actual_data_length, int timeout_msecs)
+{
+	int retval = 0;
+	agilent_82357a_urb_context_t context;
+	struct timer_list timer;
+	int submitted[agilent_82357a_num_read_buffers];
+	int requested = 0;
+	int current_urb = 0;
+	int done = 0;
+	int k;
+
+	*actual_data_length = 0;
+	sema_init(&context.complete, 0);
+	context.timed_out = 0;
+	init_timer(&timer);
+	if(timeout_msecs)
+	{
+		timer.expires = jiffies + msecs_to_jiffies(timeout_msecs);
+		timer.function = agilent_82357a_timeout_handler;
+		timer.data = (unsigned long) &context;
+		add_timer(&timer);
+	}
+	for(k = 0; k < agilent_82357a_num_read_buffers; k++)
+	{
+		submitted[k] = 0;
+		if(requested >= reply_length || retval) continue;
+		retval = agilent_82357a_submit_read_urb(a_priv, k, reply_length - requested, &context);
+		if(retval == 0)
+		{
+			submitted[k] = a_priv->read_urbs[k]->transfer_buffer_length;
+			requested += submitted[k];
+		}
+	}
+	// bulk urbs on one endpoint complete in the order they were submitted
+	while(retval == 0 && done == 0 && submitted[current_urb])
+	{
+		struct urb *urb = a_priv->read_urbs[current_urb];
+
+		if(down_interruptible(&context.complete))
+		{
+			printk("%s: %s: interrupted\n", __FILE__, __FUNCTION__);
+			retval = -ERESTARTSYS;
+			break;
+		}
+		if(context.timed_out)
+		{
+			retval = -ETIMEDOUT;
+			break;
+		}
+		submitted[current_urb] = 0;
+		if(urb->status)
+		{
+			retval = urb->status;
+			break;
+		}
+		agilent_82357a_consume_read_data(state, a_priv->read_buffers[current_urb], urb->actual_length);
+		*actual_data_length += urb->actual_length;
+		if(urb->actual_length < urb->transfer_buffer_length || *actual_data_length >= reply_length)
+		{
+			done = 1;
+			break;
+		}
+		if(requested < reply_length)
+		{
+			retval = agilent_82357a_submit_read_urb(a_priv, current_urb, reply_length - requested, &context);
+			if(retval == 0)
+			{
+				submitted[current_urb] = urb->transfer_buffer_length;
+				requested += submitted[current_urb];
+			}
+		}
+		current_urb = (current_urb + 1) % agilent_82357a_num_read_buffers;
+	}
+	/* Whatever arrived before a timeout or signal is still part of the
+	 * reply, so pick it up in order once the urbs are dead. */
+	for(k = 0; k < agilent_82357a_num_read_buffers; k++)
+	{
+		int j = (current_urb + k) % agilent_82357a_num_read_buffers;
+
+		if(submitted[j] == 0) continue;
+		usb_kill_urb(a_priv->read_urbs[j]);
+		if(done) continue;
+		agilent_82357a_consume_read_data(state, a_priv->read_buffers[j], a_priv->read_urbs[j]->actual_length);
+		*actual_data_length += a_priv->read_urbs[j]->actual_length;
+		if(a_priv->read_urbs[j]->actual_length < submitted[j])
+			done = 1;
+	}
+	if(timer_pending(&timer))
+		del_timer_sync(&timer);
+	return retval;
+}
+
 int agilent_82357a_receive_control_msg(agilent_82357a_private_t *a_priv, __u8 request, __u8 requesttype, __u16 value,
 	__u16 index, void *data, __u16 size, int timeout_msecs)
 {
@@ -278,6 +439,8 @@ int agilent_82357a_write_registers(agilent_82357a_private_t *a_priv, const struc
 	static const int header_length = 2;
 	static const int max_writes = 31;
 
+	agilent_82357a_invalidate_status_cache(a_priv);
+
 	if(num_writes > max_writes)
 	{
 		printk("%s: %s: bug! num_writes=%i too large\n", __FILE__, __FUNCTION__, num_writes);
@@ -483,19 +646,20 @@ int agilent_82357a_read(gpib_board_t *board, uint8_t *buffer, size_t length, int
 {
 	int retval;
 	agilent_82357a_private_t *a_priv = board->private_data;
-	uint8_t *out_data, *in_data;
-	int out_data_length, in_data_length;
+	uint8_t *out_data;
 	int bytes_written, bytes_read;
 	int i = 0;
 	uint8_t trailing_flags;
 	unsigned long start_jiffies = jiffies;
 	int msec_timeout;
+	struct agilent_82357a_read_state state;
 
 	*nbytes = 0;
 	*end = 0;
-	out_data_length = 0x9;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL) return -ENOMEM;
+	agilent_82357a_invalidate_status_cache(a_priv);
+	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
+	if(retval) return retval;
+	out_data = a_priv->out_buffer;
 	out_data[i++] = DATA_PIPE_CMD_READ;
 	out_data[i++] = 0;	//primary address when ARF_NO_ADDR is not set
 	out_data[i++] = 0;	//secondary address when ARF_NO_ADDR is not set
@@ -509,14 +673,7 @@ int agilent_82357a_read(gpib_board_t *board, uint8_t *buffer, size_t length, int
 	out_data[i++] = (length >> 24) & 0xff;
 	out_data[i++] = a_priv->eos_char;
 	msec_timeout = (board->usec_timeout + 999) / 1000;
-	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
-	if(retval)
-	{
-		kfree(out_data);
-		return retval;
-	}
 	retval = agilent_82357a_send_bulk_msg(a_priv, out_data, i, &bytes_written, msec_timeout);
-	kfree(out_data);
 	if(retval || bytes_written != i)
 	{
 		printk("%s: agilent_82357a_send_bulk_msg returned %i, bytes_written=%i, i=%i\n", __FILE__, retval, bytes_written, i);
@@ -524,18 +681,15 @@ int agilent_82357a_read(gpib_board_t *board, uint8_t *buffer, size_t length, int
 		if(retval < 0) return retval;
 		return -EIO;
 	}
-	in_data_length = length + 1;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL)
-	{
-		mutex_unlock(&a_priv->bulk_transfer_lock);
-		return -ENOMEM;
-	}
+	memset(&state, 0, sizeof(state));
+	state.buffer = buffer;
+	state.length = length;
 	if(board->usec_timeout != 0)
 		msec_timeout -= jiffies_to_msecs(jiffies - start_jiffies) - 1;
 	if(msec_timeout >= 0)
 	{
-		retval = agilent_82357a_receive_bulk_msg(a_priv, in_data, in_data_length,
+		// the data is followed by a byte of trailing flags
+		retval = agilent_82357a_receive_bulk_stream(a_priv, &state, length + 1,
 			&bytes_read, msec_timeout);
 	}else
 	{
@@ -547,10 +701,11 @@ int agilent_82357a_read(gpib_board_t *board, uint8_t *buffer, size_t length, int
 		int extra_bytes_read;
 		int extra_bytes_retval;
 		agilent_82357a_abort(a_priv, 1);
-		extra_bytes_retval = agilent_82357a_receive_bulk_msg(a_priv, in_data + bytes_read, in_data_length - bytes_read,
-			&extra_bytes_read, 100);
-		printk("%s: %s: agilent_82357a_receive_bulk_msg timed out, bytes_read=%i, extra_bytes_read=%i\n",
+		extra_bytes_retval = agilent_82357a_receive_bulk_msg(a_priv, a_priv->read_buffers[0],
+			agilent_82357a_read_buffer_length, &extra_bytes_read, 100);
+		printk("%s: %s: agilent_82357a_receive_bulk_stream timed out, bytes_read=%i, extra_bytes_read=%i\n",
 			__FILE__, __FUNCTION__, bytes_read, extra_bytes_read);
+		agilent_82357a_consume_read_data(&state, a_priv->read_buffers[0], extra_bytes_read);
 		bytes_read += extra_bytes_read;
 		if(extra_bytes_retval)
 		{
@@ -560,30 +715,36 @@ int agilent_82357a_read(gpib_board_t *board, uint8_t *buffer, size_t length, int
 		}
 	}else if(retval)
 	{
-		printk("%s: %s: agilent_82357a_receive_bulk_msg returned %i, bytes_read=%i\n", __FILE__, __FUNCTION__,
+		printk("%s: %s: agilent_82357a_receive_bulk_stream returned %i, bytes_read=%i\n", __FILE__, __FUNCTION__,
 			retval, bytes_read);
 		agilent_82357a_abort(a_priv, 0);
 	}
 	mutex_unlock(&a_priv->bulk_transfer_lock);
-	if(bytes_read > length + 1)
-	{
-		bytes_read = length + 1;
-		printk("%s: %s: bytes_read > length? truncating", __FILE__, __FUNCTION__);
-	}
-	//printk("%s: %s: received response:\n", __FILE__, __FUNCTION__);
-	//agilent_82357a_dump_raw_block(in_data, in_data_length);
-	if(bytes_read >= 1)
+	if(state.have_pending)
 	{
-		memcpy(buffer, in_data, bytes_read - 1);
-		trailing_flags = in_data[bytes_read - 1];
-		*nbytes = bytes_read - 1;
+		trailing_flags = state.pending;
+		*nbytes = state.count;
 		if(trailing_flags & (ATRF_EOI | ATRF_EOS)) *end = 1;
 	}
-	kfree(in_data);
 	//FIXME check trailing flags for error
 	return retval;
 }
 
+/* Makes sure out_buffer can hold length bytes, only reallocating when a
+ * write is larger than any seen before.  Caller must hold bulk_transfer_lock. */
+static int agilent_82357a_reserve_out_buffer(agilent_82357a_private_t *a_priv, int length)
+{
+	uint8_t *new_buffer;
+
+	if(length <= a_priv->out_buffer_length) return 0;
+	new_buffer = kmalloc(length, GFP_KERNEL);
+	if(new_buffer == NULL) return -ENOMEM;
+	kfree(a_priv->out_buffer);
+	a_priv->out_buffer = new_buffer;
+	a_priv->out_buffer_length = length;
+	return 0;
+}
+
 static ssize_t agilent_82357a_generic_write(gpib_board_t *board, uint8_t *buffer, size_t length,
 	int send_commands, int send_eoi, size_t *bytes_written)
 {
@@ -591,15 +752,21 @@ static ssize_t agilent_82357a_generic_write(gpib_board_t *board, uint8_t *buffer
 	agilent_82357a_private_t *a_priv = board->private_data;
 	uint8_t *out_data;
 	uint8_t status_data[0x8];
-	int out_data_length;
 	int raw_bytes_written;
-	int i = 0, j;
+	int i = 0;
 	int msec_timeout;
 
 	*bytes_written = 0;
-	out_data_length = length + 0x8;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL) return -ENOMEM;
+	agilent_82357a_invalidate_status_cache(a_priv);
+	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
+	if(retval) return retval;
+	retval = agilent_82357a_reserve_out_buffer(a_priv, length + 0x8);
+	if(retval)
+	{
+		mutex_unlock(&a_priv->bulk_transfer_lock);
+		return retval;
+	}
+	out_data = a_priv->out_buffer;
 	out_data[i++] = DATA_PIPE_CMD_WRITE;
 	out_data[i++] = 0; // primary address when AWF_NO_ADDRESS is not set
 	out_data[i++] = 0; // secondary address when AWF_NO_ADDRESS is not set
@@ -613,19 +780,12 @@ static ssize_t agilent_82357a_generic_write(gpib_board_t *board, uint8_t *buffer
 	out_data[i++] = (length >> 8) & 0xff;
 	out_data[i++] = (length >> 16) & 0xff;
 	out_data[i++] = (length >> 24) & 0xff;
-	for(j = 0; j < length; j++)
-		out_data[i++] = buffer[j];
+	memcpy(&out_data[i], buffer, length);
+	i += length;
 	//printk("%s: sending bulk msg(), send_commands=%i\n", __FUNCTION__, send_commands);
 	clear_bit(AIF_WRITE_COMPLETE_BN, &a_priv->interrupt_flags);
 	msec_timeout = board->usec_timeout + 999 / 1000;
-	retval = mutex_lock_interruptible(&a_priv->bulk_transfer_lock);
-	if(retval)
-	{
-		kfree(out_data);
-		return retval;
-	}
 	retval = agilent_82357a_send_bulk_msg(a_priv, out_data, i, &raw_bytes_written, msec_timeout);
-	kfree(out_data);
 	if(retval || raw_bytes_written != i)
 	{
 		agilent_82357a_abort(a_priv, 0);
@@ -819,10 +979,41 @@ void agilent_82357a_disable_eos(gpib_board_t *board)
 	a_priv->eos_mode &= ~REOS;
 }
 
+// reads ADSR or BSR, or returns the cached value if it is recent enough
+static int agilent_82357a_read_status_register(agilent_82357a_private_t *a_priv, unsigned short address, uint8_t *value)
+{
+	struct agilent_82357a_register_pairlet reg;
+	uint8_t *cached = address == ADSR ? &a_priv->cached_adsr : &a_priv->cached_bsr;
+	ktime_t *time = address == ADSR ? &a_priv->adsr_time : &a_priv->bsr_time;
+	unsigned long flags;
+	int fresh;
+	int retval;
+
+	spin_lock_irqsave(&a_priv->status_cache_lock, flags);
+	fresh = agilent_82357a_cache_is_fresh(address == ADSR ? a_priv->adsr_valid : a_priv->bsr_valid, *time);
+	*value = *cached;
+	spin_unlock_irqrestore(&a_priv->status_cache_lock, flags);
+	if(fresh) return 0;
+
+	reg.address = address;
+	retval = agilent_82357a_read_registers(a_priv, &reg, 1, 0);
+	if(retval) return retval;
+	*value = reg.value;
+	spin_lock_irqsave(&a_priv->status_cache_lock, flags);
+	*cached = reg.value;
+	*time = ktime_get();
+	if(address == ADSR)
+		a_priv->adsr_valid = 1;
+	else
+		a_priv->bsr_valid = 1;
+	spin_unlock_irqrestore(&a_priv->status_cache_lock, flags);
+	return 0;
+}
+
 unsigned int agilent_82357a_update_status( gpib_board_t *board, unsigned int clear_mask )
 {
 	agilent_82357a_private_t *a_priv = board->private_data;
-	struct agilent_82357a_register_pairlet address_status;
+	uint8_t adsr;
 	int retval;
 	unsigned long status;
 
@@ -832,25 +1023,24 @@ unsigned int agilent_82357a_update_status( gpib_board_t *board, unsigned int cle
 		status |= CIC;
 	else
 		status &= ~CIC;
-	address_status.address = ADSR;
-	retval = agilent_82357a_read_registers(a_priv, &address_status, 1, 0);
+	retval = agilent_82357a_read_status_register(a_priv, ADSR, &adsr);
 	if(retval)
 	{
 		printk("%s: %s: agilent_82357a_read_registers() returned error\n", __FILE__, __FUNCTION__);
 		return status;
 	}
 	// check for remote/local
-	if(address_status.value & HR_REM)
+	if(adsr & HR_REM)
 		set_bit( REM_NUM, &status );
 	else
 		clear_bit( REM_NUM, &status );
 	// check for lockout
-	if(address_status.value & HR_LLO)
+	if(adsr & HR_LLO)
 		set_bit( LOK_NUM, &status );
 	else
 		clear_bit( LOK_NUM, &status );
 	// check for ATN
-	if(address_status.value & HR_ATN)
+	if(adsr & HR_ATN)
 	{
 		set_bit( ATN_NUM, &status );
 	}else
@@ -858,12 +1048,12 @@ unsigned int agilent_82357a_update_status( gpib_board_t *board, unsigned int cle
 		clear_bit( ATN_NUM, &status );
 	}
 	// check for talker/listener addressed
-	if(address_status.value & HR_TA)
+	if(adsr & HR_TA)
 	{
 		set_bit( TACS_NUM, &status );
 	}else
 		clear_bit( TACS_NUM, &status );
-	if(address_status.value & HR_LA)
+	if(adsr & HR_LA)
 	{
 		set_bit(LACS_NUM, &status);
 	}else
@@ -964,32 +1154,31 @@ void agilent_82357a_return_to_local( gpib_board_t *board )
 int agilent_82357a_line_status( const gpib_board_t *board )
 {
 	agilent_82357a_private_t *a_priv = board->private_data;
-	struct agilent_82357a_register_pairlet bus_status;
+	uint8_t bsr;
 	int retval;
 	int status = ValidALL;
 
-	bus_status.address = BSR;
-	retval = agilent_82357a_read_registers(a_priv, &bus_status, 1, 0);
+	retval = agilent_82357a_read_status_register(a_priv, BSR, &bsr);
 	if(retval)
 	{
 		printk("%s: %s: agilent_82357a_read_registers() returned error\n", __FILE__, __FUNCTION__);
 		return 0;
 	}
-	if( bus_status.value & BSR_REN_BIT )
+	if( bsr & BSR_REN_BIT )
 		status |= BusREN;
-	if( bus_status.value & BSR_IFC_BIT )
+	if( bsr & BSR_IFC_BIT )
 		status |= BusIFC;
-	if( bus_status.value & BSR_SRQ_BIT )
+	if( bsr & BSR_SRQ_BIT )
 		status |= BusSRQ;
-	if( bus_status.value & BSR_EOI_BIT )
+	if( bsr & BSR_EOI_BIT )
 		status |= BusEOI;
-	if( bus_status.value & BSR_NRFD_BIT )
+	if( bsr & BSR_NRFD_BIT )
 		status |= BusNRFD;
-	if( bus_status.value & BSR_NDAC_BIT )
+	if( bsr & BSR_NDAC_BIT )
 		status |= BusNDAC;
-	if( bus_status.value & BSR_DAV_BIT )
+	if( bsr & BSR_DAV_BIT )
 		status |= BusDAV;
-	if( bus_status.value & BSR_ATN_BIT )
+	if( bsr & BSR_ATN_BIT )
 		status |= BusATN;
 	return status;
 }
@@ -1050,7 +1239,12 @@ void agilent_82357a_interrupt_complete(struct urb *urb PT_REGS_ARG)
 	if(test_bit(AIF_WRITE_COMPLETE_BN, &interrupt_flags))
 		set_bit(AIF_WRITE_COMPLETE_BN, &a_priv->interrupt_flags);
 	if(test_bit(AIF_SRQ_BN, &interrupt_flags))
+	{
 		set_bit(SRQI_NUM, &board->status);
+		spin_lock(&a_priv->status_cache_lock);
+		a_priv->cached_bsr |= BSR_SRQ_BIT;
+		spin_unlock(&a_priv->status_cache_lock);
+	}
 	retval = usb_submit_urb(a_priv->interrupt_urb, GFP_ATOMIC);
 	if(retval)
 	{
@@ -1119,18 +1313,24 @@ static int agilent_82357a_reset_usb_configuration(gpib_board_t *board)
 
 static void agilent_82357a_cleanup_urbs(agilent_82357a_private_t *a_priv)
 {
+	int i;
+
 	if(a_priv && a_priv->bus_interface)
 	{
 		if(a_priv->interrupt_urb)
 			usb_kill_urb(a_priv->interrupt_urb);
 		if(a_priv->bulk_urb)
 			usb_kill_urb(a_priv->bulk_urb);
+		for(i = 0; i < agilent_82357a_num_read_buffers; i++)
+			if(a_priv->read_urbs[i])
+				usb_kill_urb(a_priv->read_urbs[i]);
 	}
 };
 
 static int agilent_82357a_allocate_private(gpib_board_t *board)
 {
 	agilent_82357a_private_t *a_priv;
+	int i;
 
 	board->private_data = kmalloc(sizeof(agilent_82357a_private_t), GFP_KERNEL);
 	if(board->private_data == NULL)
@@ -1141,13 +1341,36 @@ static int agilent_82357a_allocate_private(gpib_board_t *board)
 	mutex_init(&a_priv->bulk_alloc_lock);
 	mutex_init(&a_priv->control_alloc_lock);
 	mutex_init(&a_priv->interrupt_alloc_lock);
+	spin_lock_init(&a_priv->status_cache_lock);
+	for(i = 0; i < agilent_82357a_num_read_buffers; i++)
+	{
+		a_priv->read_urbs[i] = usb_alloc_urb(0, GFP_KERNEL);
+		if(a_priv->read_urbs[i] == NULL)
+			return -ENOMEM;
+		a_priv->read_buffers[i] = kmalloc(agilent_82357a_read_buffer_length, GFP_KERNEL);
+		if(a_priv->read_buffers[i] == NULL)
+			return -ENOMEM;
+	}
+	a_priv->out_buffer = kmalloc(agilent_82357a_initial_out_buffer_length, GFP_KERNEL);
+	if(a_priv->out_buffer == NULL)
+		return -ENOMEM;
+	a_priv->out_buffer_length = agilent_82357a_initial_out_buffer_length;
 	return 0;
 }
 
 static void agilent_82357a_free_private(agilent_82357a_private_t *a_priv)
 {
+	int i;
+
 	if(a_priv->interrupt_urb)
 		usb_free_urb(a_priv->interrupt_urb);
+	for(i = 0; i < agilent_82357a_num_read_buffers; i++)
+	{
+		if(a_priv->read_urbs[i])
+			usb_free_urb(a_priv->read_urbs[i]);
+		kfree(a_priv->read_buffers[i]);
+	}
+	kfree(a_priv->out_buffer);
 	kfree(a_priv);
 	return;
 }
@@ -1428,7 +1651,7 @@ gpib_interface_t agilent_82357a_gpib_interface =
 	.serial_poll_status = agilent_82357a_serial_poll_status,
 	.t1_delay = agilent_82357a_t1_delay,
 	.return_to_local = agilent_82357a_return_to_local,
-	.no_7_bit_eos = 1
+	.no_7_bit_eos = 1,
 };
 
 // Table with the USB-devices: just now only testing IDs
@@ -137,6 +137,15 @@ enum xfer_abort_type
 	XA_FLUSH = 0x1
 };
 
+enum agilent_82357a_buffer_lengths
+{
+	// read data is received in chunks of this size, with this many urbs in flight
+	agilent_82357a_read_buffer_length = 0x1000,
+	agilent_82357a_num_read_buffers = 2,
+	// the write buffer starts out this big and grows to the largest write seen
+	agilent_82357a_initial_out_buffer_length = 0x1000 + 0x8,
+};
+
 // struct which defines local data for each 82357 device
 typedef struct
 {
@@ -146,6 +155,12 @@ typedef struct
 	unsigned short hw_control_bits;
 	unsigned long interrupt_flags;
 	struct urb *bulk_urb;
+	/* allocated at attach, the read urbs and buffers and the out buffer are
+	 * only used with bulk_transfer_lock held */
+	struct urb *read_urbs[agilent_82357a_num_read_buffers];
+	uint8_t *read_buffers[agilent_82357a_num_read_buffers];
+	uint8_t *out_buffer;
+	int out_buffer_length;
 	struct urb *interrupt_urb;
 	uint8_t interrupt_buffer[0x8];
 	struct mutex bulk_transfer_lock;
@@ -154,6 +169,15 @@ typedef struct
 	struct mutex control_alloc_lock;
 	unsigned bulk_out_endpoint;
 	unsigned interrupt_in_endpoint;
+	/* last ADSR and BSR values read, so status queries between bus
+	 * operations don't need a round trip to the adapter */
+	spinlock_t status_cache_lock;
+	ktime_t adsr_time;
+	ktime_t bsr_time;
+	uint8_t cached_adsr;
+	uint8_t cached_bsr;
+	unsigned adsr_valid : 1;
+	unsigned bsr_valid : 1;
 	unsigned is_cic : 1;
 } agilent_82357a_private_t;
 
@@ -163,6 +187,18 @@ typedef struct
 	unsigned timed_out : 1;
 } agilent_82357a_urb_context_t;
 
+/* Where the data of a read goes as it arrives.  The last byte received so
+ * far is held back in pending, since the final one is the trailing flags
+ * byte rather than data. */
+struct agilent_82357a_read_state
+{
+	uint8_t *buffer;
+	size_t length;
+	size_t count;
+	uint8_t pending;
+	unsigned have_pending : 1;
+};
+
 struct agilent_82357a_register_pairlet
 {
 	short address;
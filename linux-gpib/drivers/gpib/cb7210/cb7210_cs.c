@@ -366,6 +366,7 @@ gpib_interface_t cb_pcmcia_interface =
 	serial_poll_status: cb7210_serial_poll_status,
 	t1_delay: cb7210_t1_delay,
 	return_to_local: cb7210_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t cb_pcmcia_accel_interface =
@@ -394,6 +395,7 @@ gpib_interface_t cb_pcmcia_accel_interface =
 	serial_poll_status: cb7210_serial_poll_status,
 	t1_delay: cb7210_t1_delay,
 	return_to_local: cb7210_return_to_local,
+	direct_io: 1,
 };
 
 int cb_pcmcia_attach( gpib_board_t *board, gpib_board_config_t config )
@@ -200,6 +200,7 @@ gpib_interface_t cb_pci_accel_interface =
 	serial_poll_status: cb7210_serial_poll_status,
 	t1_delay: cb7210_t1_delay,
 	return_to_local: cb7210_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t cb_pci_interface =
@@ -228,6 +229,7 @@ gpib_interface_t cb_pci_interface =
 	serial_poll_status: cb7210_serial_poll_status,
 	t1_delay: cb7210_t1_delay,
 	return_to_local: cb7210_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t cb_isa_unaccel_interface =
@@ -284,6 +286,7 @@ gpib_interface_t cb_isa_interface =
 	serial_poll_status: cb7210_serial_poll_status,
 	t1_delay: cb7210_t1_delay,
 	return_to_local: cb7210_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t cb_isa_accel_interface =
@@ -312,6 +315,7 @@ gpib_interface_t cb_isa_accel_interface =
 	serial_poll_status: cb7210_serial_poll_status,
 	t1_delay: cb7210_t1_delay,
 	return_to_local: cb7210_return_to_local,
+	direct_io: 1,
 };
 
 int cb7210_allocate_private(gpib_board_t *board)
@@ -348,8 +352,7 @@ int cb7210_generic_attach(gpib_board_t *board)
 		return -ENOMEM;
 	cb_priv = board->private_data;
 	nec_priv = &cb_priv->nec7210_priv;
-	nec_priv->read_byte = nec7210_locking_ioport_read_byte;
-	nec_priv->write_byte = nec7210_locking_ioport_write_byte;
+	nec_priv->io_method = NEC7210_IO_LOCKING_PORT;
 	nec_priv->offset = cb7210_reg_offset;
 	nec_priv->type = CB7210;
 	return 0;
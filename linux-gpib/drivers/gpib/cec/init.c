@@ -196,8 +196,7 @@ int cec_generic_attach(gpib_board_t *board)
 		return -ENOMEM;
 	cec_priv = board->private_data;
 	nec_priv = &cec_priv->nec7210_priv;
-	nec_priv->read_byte = nec7210_ioport_read_byte;
-	nec_priv->write_byte = nec7210_ioport_write_byte;
+	nec_priv->io_method = NEC7210_IO_PORT;
 	nec_priv->offset = cec_reg_offset;
 	nec_priv->type = NEC7210;	// guess
 	return 0;
@@ -41,9 +41,16 @@ int push_gpib_event( gpib_board_t *board, short event_type );
 int pop_gpib_event( gpib_event_queue_t *queue, short *event_type );
 int gpib_request_pseudo_irq(gpib_board_t *board, irqreturn_t (*handler)(int, void * PT_REGS_ARG));
 void gpib_free_pseudo_irq(gpib_board_t *board);
+int gpib_pseudo_irq_busy_poll(gpib_board_t *board);
 
 extern gpib_board_t board_array[GPIB_MAX_NUM_BOARDS];
 
+/* status bits only the core changes, waking the descriptor's own wait queue
+ * (or board->rqs_wait for RQS).  Waiting for any other bit means sleeping on
+ * board->wait, which the driver wakes from its interrupt handler.  END is
+ * read from board->status, so it is left out. */
+#define GPIB_DESCRIPTOR_STATUS_MASK ( TIMO | CMPL | RQS )
+
 extern struct list_head registered_drivers;
 
 #if defined( GPIB_CONFIG_KERNEL_DEBUG )
@@ -54,14 +61,5 @@ extern struct list_head registered_drivers;
 
 #include <asm/io.h>
 
-void writeb_wrapper(unsigned int value, void *address);
-unsigned int readb_wrapper(void *address);
-void outb_wrapper(unsigned int value, void *address);
-unsigned int inb_wrapper(void *address);
-void writew_wrapper(unsigned int value, void *address);
-unsigned int readw_wrapper(void *address);
-void outw_wrapper(unsigned int value, void *address);
-unsigned int inw_wrapper(void *address);
-
 #endif	// _GPIB_P_H
 
@@ -39,6 +39,31 @@ typedef struct
 	int handle;
 } read_write_ioctl_t;
 
+/* argument for IBXFER, which does a complete addressed read or write
+ * (eos/timeout setup, addressing, data transfer and status) in one ioctl.
+ * IBAIO_START runs the same transfer in the background; CMPL is set for
+ * the handle when it is done, and IBAIO_COMPLETE then returns the result
+ * just as IBXFER would have.  IBAIO_CANCEL makes the transfer give up
+ * early.  The command flag sends the buffer as command bytes instead of
+ * data (only without address_target). */
+typedef struct
+{
+	uint64_t buffer_ptr;
+	unsigned requested_transfer_count;
+	unsigned completed_transfer_count;
+	unsigned usec_timeout;
+	int handle;
+	unsigned int pad;	/* address of device to talk/listen, if address_target is set */
+	int sad;
+	int eos;
+	int eos_flags;
+	int end;	/* send EOI with last byte on writes, END received on reads */
+	int ibsta;	/* status after the transfer */
+	unsigned address_target : 1;
+	unsigned write : 1;
+	unsigned command : 1;
+} xfer_ioctl_t;
+
 typedef struct
 {
 	unsigned int handle;
@@ -59,6 +84,19 @@ typedef struct
 	uint8_t status_byte;
 } serial_poll_ioctl_t;
 
+/* Serial polls each address in the array of num_polls serial_poll_ioctl_t
+ * at poll_list_ptr, using a single SPE/SPD sequence.  If stop_on_rqs is set,
+ * polling stops after the first status byte with the rqs bit set.
+ * num_completed returns the number of status bytes which were filled in. */
+typedef struct
+{
+	uint64_t poll_list_ptr;
+	unsigned int num_polls;
+	unsigned int usec_timeout;
+	unsigned int num_completed;
+	unsigned stop_on_rqs : 1;
+} serial_poll_list_ioctl_t;
+
 typedef struct
 {
 	int eos;
@@ -99,16 +137,52 @@ typedef struct
 	int autopolling;
 	int is_system_controller;
 	unsigned int t1_delay;
+	unsigned int buffer_length;
+	unsigned int max_buffer_length;
 	unsigned ist : 1;
 	unsigned no_7_bit_eos : 1;
 } board_info_ioctl_t;
 
+/* Layout of the read-only page which can be mmapped from a board's device file.
+ * info_generation is incremented whenever anything reported by the IBBOARD_INFO
+ * ioctl changes, so user space can cache IBBOARD_INFO results.  usec_timeout_generation
+ * and eos_generation are incremented by every IBTMO and IBEOS respectively (and
+ * when the board goes online or offline), so user space can skip pushing
+ * settings the board already has. */
+typedef struct gpib_board_state_page
+{
+	uint32_t info_generation;
+	uint32_t usec_timeout_generation;
+	uint32_t eos_generation;
+} board_state_page_t;
+
 typedef struct
 {
 	int pci_bus;
 	int pci_slot;
 } select_pci_ioctl_t;
 
+/* Sets the length of the board's transfer buffer.  If max_buffer_length is
+ * larger than buffer_length, the buffer is grown (up to max_buffer_length)
+ * when the board sees a run of transfers that don't fit in it.  A buffer_length
+ * of zero keeps the current length. */
+typedef struct
+{
+	unsigned int buffer_length;
+	unsigned int max_buffer_length;
+} buffer_size_ioctl_t;
+
+/* Sets how often boards without a usable interrupt are polled, see
+ * struct gpib_pseudo_irq.  A negative value in any field keeps the current
+ * setting.  A busy_poll_usec of zero disables busy polling, one longer than
+ * the minimum period is cut down to it. */
+typedef struct
+{
+	int min_period_usec;
+	int max_period_usec;
+	int busy_poll_usec;
+} pseudo_irq_ioctl_t;
+
 typedef struct
 {
 	uint8_t config;
@@ -128,6 +202,15 @@ typedef struct
 	int sad;
 } sad_ioctl_t;
 
+/* Sets which status bits make poll() report the device file as readable
+ * for the descriptor given by handle.  A wait_mask of zero means the
+ * descriptor is ignored by poll(). */
+typedef struct
+{
+	unsigned int handle;
+	int wait_mask;
+} poll_mask_ioctl_t;
+
 typedef short event_ioctl_t;
 typedef int rsc_ioctl_t;
 typedef unsigned int t1_delay_ioctl_t;
@@ -173,7 +256,16 @@ enum gpib_ioctl
 	IBLOC = _IO( GPIB_CODE, 36 ),
 
 	IBAUTOSPOLL = _IOW( GPIB_CODE, 38, autospoll_ioctl_t ),
-	IBONL = _IOW( GPIB_CODE, 39, online_ioctl_t )
+	IBONL = _IOW( GPIB_CODE, 39, online_ioctl_t ),
+	IBXFER = _IOWR( GPIB_CODE, 40, xfer_ioctl_t ),
+	IBBUFFER_SIZE = _IOW( GPIB_CODE, 41, buffer_size_ioctl_t ),
+	IBRSP_LIST = _IOWR( GPIB_CODE, 42, serial_poll_list_ioctl_t ),
+	IBPOLL_MASK = _IOW( GPIB_CODE, 43, poll_mask_ioctl_t ),
+	IBAIO_START = _IOW( GPIB_CODE, 44, xfer_ioctl_t ),
+	IBAIO_COMPLETE = _IOWR( GPIB_CODE, 45, xfer_ioctl_t ),
+	IBAIO_CANCEL = _IOW( GPIB_CODE, 46, int ),
+	IBPSEUDO_IRQ = _IOW( GPIB_CODE, 47, pseudo_irq_ioctl_t ),
+	IBPIO_POLL = _IOW( GPIB_CODE, 48, unsigned int )
 };
 
 #endif	/* _GPIB_IOCTL_H */
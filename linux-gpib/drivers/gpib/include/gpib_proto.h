@@ -3,15 +3,21 @@
 #define GPIB_PROTO_INCLUDED
 
 #include <linux/fs.h>
+#include "gpib_ioctl.h"
 
 int ibopen( struct inode *inode, struct file *filep );
 int ibclose( struct inode *inode, struct file *file );
+int ibmmap( struct file *filep, struct vm_area_struct *vma );
+unsigned int ibpoll( struct file *filep, struct poll_table_struct *wait );
 long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg );
 int osInit( void );
 void osReset( void );
-void watchdog_timeout( unsigned long arg );
+void osInitTimer( gpib_board_t *board );
 void osStartTimer( gpib_board_t *board, unsigned int usec_timeout );
 void osRemoveTimer( gpib_board_t *board );
+void osSetDeadline( gpib_board_t *board, unsigned int usec_timeout );
+void osClearDeadline( gpib_board_t *board );
+void osAbortIo( gpib_board_t *board );
 void osSendEOI( void );
 void osSendEOI( void );
 void init_gpib_board( gpib_board_t *board );
@@ -22,6 +28,8 @@ static inline unsigned long usec_to_jiffies(unsigned int usec)
 	return 1 + ( usec + usec_per_jiffy - 1) / usec_per_jiffy;
 };
 int serial_poll_all( gpib_board_t *board, unsigned int usec_timeout );
+int serial_poll_list( gpib_board_t *board, serial_poll_ioctl_t *polls, unsigned int num_polls,
+	unsigned int usec_timeout, int stop_on_rqs, unsigned int *num_completed );
 void init_gpib_descriptor( gpib_descriptor_t *desc );
 int dvrsp(gpib_board_t *board, unsigned int pad, int sad,
 	unsigned int usec_timeout, uint8_t *result );
@@ -51,5 +59,8 @@ int general_ibstatus( gpib_board_t *board, const gpib_status_queue_t *device,
 	int clear_mask, int set_mask, gpib_descriptor_t *desc );
 int io_timed_out( gpib_board_t *board );
 int ibppc( gpib_board_t *board, uint8_t configuration );
+void board_info_changed( gpib_board_t *board );
+void board_timeout_changed( gpib_board_t *board );
+void board_eos_changed( gpib_board_t *board );
 
 #endif /* GPIB_PROTO_INCLUDED */
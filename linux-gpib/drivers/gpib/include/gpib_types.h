@@ -25,22 +25,43 @@
  * This really should be in a different header file.
  */
 #include "gpib/gpib_user.h"
+#include "gpib_ioctl.h"
 #include <asm/atomic.h>
 #include <linux/mutex.h>
+#include <linux/rwsem.h>
 #include <linux/wait.h>
 #include <linux/sched.h>
 #include <linux/timer.h>
+#include <linux/hrtimer.h>
 #include <linux/interrupt.h>
 
 typedef struct gpib_interface_struct gpib_interface_t;
 typedef struct gpib_board_struct gpib_board_t;
 
+/* number of valid primary addresses, or secondary addresses */
+#define GPIB_NUM_ADDRESSES 31
+
 typedef struct
 {
 	void *init_data;
 	int init_data_length;
 } gpib_board_config_t;
 
+/* Limits and shortcuts of a board the core acts on.  It only holds what the
+ * core uses, it isn't a general description of the hardware and isn't
+ * passed on to user space.  Zero in any field means none, no, or unknown,
+ * which gets the same treatment as before the field existed.  Only ni_usb
+ * sets anything so far. */
+typedef struct
+{
+	/* longest transfer read() and write() can do in one call, the core
+	 * won't grow board->buffer past it */
+	unsigned int max_transfer_length;
+	/* update_status() always reports the SRQ line in SRQI, so the core
+	 * doesn't need to call line_status() to find it */
+	unsigned status_has_srqi : 1;
+} gpib_interface_caps_t;
+
 struct gpib_interface_struct
 {
 	/* name of board */
@@ -134,37 +155,83 @@ struct gpib_interface_struct
 	void ( *return_to_local )( gpib_board_t *board );
 	/* board does not support 7 bit eos comparisons */
 	unsigned no_7_bit_eos : 1;
+	/* read() and write() may be passed a buffer which is really the user's
+	 * pages mapped with vmap(), so large transfers can skip the copy through
+	 * board->buffer.  Only set this if your driver accesses the buffer
+	 * with the cpu, or dma maps it a page at a time with vmalloc_to_page()
+	 * (no dma mapping of the whole buffer, no usb transfers straight from it). */
+	unsigned direct_io : 1;
+	gpib_interface_caps_t caps;
 };
 
+/* fixed size ring of events, allocated when the board goes online so pushing
+ * from interrupt context never allocates memory */
 typedef struct
 {
-	struct list_head event_head;
+	short *events;
+	unsigned int size;
+	unsigned int front;
 	spinlock_t lock;
 	unsigned int num_events;
 	unsigned dropped_event : 1;
+	/* on overflow discard the new event instead of the oldest queued one */
+	unsigned drop_newest : 1;
 } gpib_event_queue_t;
 
 static inline void init_event_queue( gpib_event_queue_t *queue )
 {
-	INIT_LIST_HEAD( &queue->event_head );
+	queue->events = NULL;
+	queue->size = 0;
+	queue->front = 0;
 	queue->num_events = 0;
 	queue->dropped_event = 0;
+	queue->drop_newest = 0;
 	spin_lock_init( &queue->lock );
 }
 
-/* struct for supporting polling operation when irq is not available */
+/* struct for supporting polling operation when irq is not available.
+ * Boards with a real irq may also use it, to catch changes (like ATN) their
+ * interrupts don't report; those are just polled every max_period_usec.
+ * For a board which set replaces_irq before requesting it, the period drops
+ * to min_period_usec whenever the handler reports it handled something, and
+ * doubles (up to max_period_usec) after each call which doesn't.  Such a
+ * driver about to sleep for a byte handshake can call
+ * gpib_pseudo_irq_busy_poll(), which runs the handler from its own context
+ * for up to busy_poll_usec, so byte-at-a-time transfers don't wait a whole
+ * period for each handshake.  period_usec is only written by the timer. */
 struct gpib_pseudo_irq
 {
-	struct timer_list timer;
+	struct hrtimer timer;
 	irqreturn_t (*handler)(int, void * PT_REGS_ARG);
 	atomic_t active;
+	/* set when a busy poll handled something, cleared by the timer */
+	atomic_t busy_poll_handled;
+	/* the board has no real irq, the handler only runs from here */
+	int replaces_irq;
+	unsigned int period_usec;
+	unsigned int min_period_usec;
+	unsigned int max_period_usec;
+	unsigned int busy_poll_usec;
+};
+
+enum gpib_pseudo_irq_defaults
+{
+	pseudo_irq_default_min_period_usec = 100,
+	pseudo_irq_default_max_period_usec = 10000,
+	pseudo_irq_default_busy_poll_usec = 50,
 };
 
 static inline void init_gpib_pseudo_irq( struct gpib_pseudo_irq *pseudo_irq)
 {
 	pseudo_irq->handler = NULL;
-	init_timer(&pseudo_irq->timer);
+	hrtimer_init(&pseudo_irq->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 	atomic_set(&pseudo_irq->active, 0);
+	atomic_set(&pseudo_irq->busy_poll_handled, 0);
+	pseudo_irq->replaces_irq = 0;
+	pseudo_irq->min_period_usec = pseudo_irq_default_min_period_usec;
+	pseudo_irq->max_period_usec = pseudo_irq_default_max_period_usec;
+	pseudo_irq->busy_poll_usec = pseudo_irq_default_busy_poll_usec;
+	pseudo_irq->period_usec = pseudo_irq->max_period_usec;
 }
 
 /* list so we can make a linked list of drivers */
@@ -189,6 +256,15 @@ struct gpib_board_struct
 	uint8_t *buffer;
 	/* length of buffer */
 	unsigned int buffer_length;
+	/* length buffer is allocated with when the board goes online */
+	unsigned int initial_buffer_length;
+	/* buffer may grow up to this length after a run of large transfers */
+	unsigned int max_buffer_length;
+	/* number of consecutive transfers which were too large for buffer */
+	unsigned int large_transfer_count;
+	/* Held for reading while buffer is in use, and for writing while it
+	 * is resized.  Must be locked before big_gpib_mutex. */
+	struct rw_semaphore buffer_rwsem;
 	/* Used to hold the board's current status (see update_status() above)
 	 */
 	volatile unsigned long status;
@@ -197,20 +273,34 @@ struct gpib_board_struct
 	 * watchdog timer times out.
 	 */
 	wait_queue_head_t wait;
+	/* Woken when autopolling queues status bytes, for anyone waiting on RQS */
+	wait_queue_head_t rqs_wait;
 	/* Lock that only allows one process to access this board at a time.
 	   Has to be first in any locking order, since it can be locked over
 	   multiple ioctls. */
 	struct mutex user_mutex;
 	/* Mutex which compensates for removal of "big kernel lock" from kernel.
-	   Should not be held for extended waits. */
+	   Should not be held for extended waits.  Status queries (IBWAIT,
+	   IBEVENT, IBSPOLL_BYTES, IBBOARD_INFO) don't take it. */
 	struct mutex big_gpib_mutex;
+	/* Held for writing while the driver is attached or detached, and for
+	   reading by status checks which call into the driver without
+	   big_gpib_mutex.  Locked after big_gpib_mutex. */
+	struct rw_semaphore attach_rwsem;
 	/* pid of last process to lock the board mutex */
 	pid_t locking_pid;
 	spinlock_t locking_pid_spinlock;
 	/* Spin lock for dealing with races with the interrupt handler */
 	spinlock_t spinlock;
 	/* Watchdog timer to enable timeouts */
-	struct timer_list timer;
+	struct hrtimer timer;
+	/* absolute time the current io ioctl must finish by, if deadline_active */
+	ktime_t deadline;
+	/* watchdog timers may not run past deadline.  Set and cleared outside
+	 * big_gpib_mutex, so it must not share a word with the bitfields. */
+	int deadline_active;
+	/* set by osAbortIo() to make the current io ioctl fail as if it timed out */
+	atomic_t io_aborted;
 	/* IO base address to use for non-pnp cards (set by core, driver should make local copy) */
 	void *ibbase;
 	/* IRQ to use for non-pnp cards (set by core, driver should make local copy) */
@@ -230,6 +320,20 @@ struct gpib_board_struct
 	unsigned int use_count;
 	/* list of open devices connected to this board */
 	struct list_head device_list;
+	/* the same devices indexed by primary address, then by secondary
+	 * address + 1 (slot 0 is no secondary address).  Rows are allocated
+	 * when the first device with that primary address is opened. */
+	struct gpib_status_queue_struct **device_table[ GPIB_NUM_ADDRESSES ];
+	/* Protects device_list, device_table and the status byte queues of
+	 * the devices in them.  Taken without big_gpib_mutex by IBSPOLL_BYTES. */
+	spinlock_t status_queue_lock;
+	/* what IBBOARD_INFO reports, rebuilt by board_info_changed() so
+	 * the ioctl can read it without big_gpib_mutex */
+	board_info_ioctl_t info;
+	seqlock_t info_seqlock;
+	/* page which user space can mmap read-only to find out if its cached
+	 * board info is still valid */
+	struct gpib_board_state_page *state_page;
 	/* primary address */
 	unsigned int pad;
 	/* secondary address */
@@ -252,6 +356,9 @@ struct gpib_board_struct
 	int minor;
 	/* struct to deal with polling mode*/
 	struct gpib_pseudo_irq pseudo_irq;
+	/* microseconds a byte at a time pio transfer spins waiting for the
+	 * next byte before it goes to sleep on 'wait' */
+	unsigned int pio_poll_usec;
 	/* error dong autopoll */
 	atomic_t stuck_srq;
 	/* Flag that indicates whether board is system controller of the bus */
@@ -260,37 +367,29 @@ struct gpib_board_struct
 	unsigned ist : 1;
 };
 
-/* element of event queue */
-typedef struct
-{
-	struct list_head list;
-	short event_type;
-} gpib_event_t;
-
 /* Each board has a list of gpib_status_queue_t to keep track of all open devices
  * on the bus, so we know what address to poll when we get a service request */
-typedef struct
+typedef struct gpib_status_queue_struct
 {
 	/* list_head so we can make a linked list of devices */
 	struct list_head list;
 	unsigned int pad;	/* primary gpib address */
 	int sad;	/* secondary gpib address (negative means disabled) */
-	/* stores serial poll bytes for this device */
-	struct list_head status_bytes;
+	/* ring of serial poll bytes for this device, allocated along with
+	 * the gpib_status_queue_t */
+	uint8_t *status_bytes;
+	unsigned int size;
+	unsigned int front;
 	unsigned int num_status_bytes;
 	/* number of times this address is opened */
 	unsigned int reference_count;
 	/* flags loss of status byte error due to limit on size of queue */
 	unsigned dropped_byte : 1;
+	/* on overflow discard the new byte instead of the oldest queued one */
+	unsigned drop_newest : 1;
 } gpib_status_queue_t;
 
-typedef struct
-{
-	struct list_head list;
-	uint8_t poll_byte;
-} status_byte_t;
-
-void init_gpib_status_queue( gpib_status_queue_t *device );
+gpib_status_queue_t *alloc_gpib_status_queue( gfp_t gfp_flags );
 
 /* Used to store device-descriptor-specific information */
 typedef struct
@@ -298,6 +397,13 @@ typedef struct
 	unsigned int pad;	/* primary gpib address */
 	int sad;	/* secondary gpib address (negative means disabled) */
 	atomic_t io_in_progress;
+	/* status bits which make poll() return, set by IBPOLL_MASK */
+	int poll_mask;
+	/* background transfer started by IBAIO_START, if any */
+	struct gpib_aio *aio;
+	/* wait queue of the file that owns this descriptor, woken when
+	 * io on it completes or its poll mask changes */
+	wait_queue_head_t *wait;
 	unsigned is_board : 1;
 } gpib_descriptor_t;
 
@@ -307,6 +413,10 @@ typedef struct
 	gpib_descriptor_t *descriptors[ GPIB_MAX_NUM_DESCRIPTORS ];
 	/* locked while descriptors are being allocated/deallocated */
 	struct mutex descriptors_mutex;
+	/* ibwait() and poll() on this file sleep here for CMPL, END and their
+	 * own timeouts.  It lives in the file rather than the descriptor so
+	 * closing a descriptor can't pull it out from under a sleeping poll(). */
+	wait_queue_head_t wait;
 	unsigned got_module : 1;
 } gpib_file_private_t;
 
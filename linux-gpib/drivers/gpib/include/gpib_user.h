@@ -263,7 +263,12 @@ enum ibask_option
 	IbaRsv = 0x21,	/* board only */
 	IbaBNA = 0x200,	/* device only */
 	/* linux-gpib extensions */
-	Iba7BitEOS = 0x1000	/* board only. Returns 1 if board supports 7 bit eos compares*/
+	Iba7BitEOS = 0x1000,	/* board only. Returns 1 if board supports 7 bit eos compares*/
+	IbaBufferSize = 0x1001,	/* board only. Length of driver's transfer buffer */
+	IbaMaxBufferSize = 0x1002,	/* board only. Length transfer buffer may grow to */
+	IbaTMOusec = 0x1003,	/* timeout in microseconds */
+	IbaSPollTimeUsec = 0x1004,	/* device only. serial poll timeout in microseconds */
+	IbaPPollTimeUsec = 0x1005	/* board only. parallel poll timeout in microseconds */
 };
 
 enum ibconfig_option
@@ -299,7 +304,13 @@ enum ibconfig_option
 	IbcHSCableLength = 0x1f,	/* board only */
 	IbcIst = 0x20,	/* board only */
 	IbcRsv = 0x21,	/* board only */
-	IbcBNA = 0x200	/* device only */
+	IbcBNA = 0x200,	/* device only */
+	/* linux-gpib extensions */
+	IbcBufferSize = 0x1001,	/* board only */
+	IbcMaxBufferSize = 0x1002,	/* board only */
+	IbcTMOusec = 0x1003,	/* timeout in microseconds */
+	IbcSPollTimeUsec = 0x1004,	/* device only */
+	IbcPPollTimeUsec = 0x1005	/* board only */
 };
 
 enum t1_delays
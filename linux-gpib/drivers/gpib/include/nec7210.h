@@ -23,10 +23,24 @@
 #include <linux/spinlock.h>
 #include <linux/string.h>
 #include <linux/interrupt.h>
+#include <linux/delay.h>
+#include <asm/io.h>
 
 #include "gpib_types.h"
 #include "nec7210_registers.h"
 
+/* How read_byte() and write_byte() reach the chip.  The standard methods
+ * are inlined so the per-byte loops don't make an indirect call for every
+ * register access, boards with unusual wiring use NEC7210_IO_CUSTOM. */
+enum nec7210_io_method
+{
+	NEC7210_IO_CUSTOM,	// through the read_byte and write_byte hooks
+	NEC7210_IO_PORT,	// inb/outb
+	NEC7210_IO_MEM,	// readb/writeb
+	NEC7210_IO_LOCKING_PORT,	// inb/outb under register_page_lock
+	NEC7210_IO_LOCKING_MEM,	// readb/writeb under register_page_lock
+};
+
 /* struct used to provide variables local to a nec7210 chip */
 typedef struct nec7210_private_struct nec7210_private_t;
 struct nec7210_private_struct
@@ -37,6 +51,7 @@ struct nec7210_private_struct
 	uint8_t *dma_buffer;
 	unsigned int dma_buffer_length;	// length of dma buffer
 	dma_addr_t dma_buffer_addr;	// bus address of board->buffer for use with dma
+	int dma_read_residue;	// dma read residue when the interrupt handler last checked
 	// software copy of bits written to registers
 	volatile uint8_t reg_bits[ 8 ];
 	volatile uint8_t auxa_bits;	// bits written to auxilliary register A
@@ -45,7 +60,8 @@ struct nec7210_private_struct
 	volatile unsigned long state;
 	/* lock for chips that extend the nec7210 registers by paging in alternate regs */
 	spinlock_t register_page_lock;
-	// wrappers for outb, inb, readb, or writeb
+	enum nec7210_io_method io_method;
+	// register access hooks, only used with NEC7210_IO_CUSTOM
 	uint8_t (*read_byte)(nec7210_private_t *priv, unsigned int register_number);
 	void (*write_byte)(nec7210_private_t *priv, uint8_t byte, unsigned int register_number);
 	enum nec7210_chipset type;
@@ -61,14 +77,86 @@ static inline void init_nec7210_private( nec7210_private_t *priv )
 	spin_lock_init( &priv->register_page_lock );
 }
 
-// slightly shorter way to access read_byte and write_byte
+static inline uint8_t nec7210_raw_read_byte(nec7210_private_t *priv, int iomem,
+	unsigned int register_num)
+{
+	if(iomem)
+		return readb(priv->iobase + register_num * priv->offset);
+	return inb((unsigned long)(priv->iobase) + register_num * priv->offset);
+}
+static inline void nec7210_raw_write_byte(nec7210_private_t *priv, int iomem,
+	uint8_t data, unsigned int register_num)
+{
+	if(iomem)
+		writeb(data, priv->iobase + register_num * priv->offset);
+	else
+		outb(data, (unsigned long)(priv->iobase) + register_num * priv->offset);
+}
+static inline uint8_t nec7210_locked_read_byte(nec7210_private_t *priv, int iomem,
+	unsigned int register_num)
+{
+	uint8_t retval;
+	unsigned long flags;
+
+	spin_lock_irqsave( &priv->register_page_lock, flags );
+	retval = nec7210_raw_read_byte(priv, iomem, register_num);
+	spin_unlock_irqrestore( &priv->register_page_lock, flags );
+	return retval;
+}
+/* locking makes absolutely sure noone accesses the AUXMR register
+ * faster than once per microsecond */
+static inline void nec7210_locked_write_byte(nec7210_private_t *priv, int iomem,
+	uint8_t data, unsigned int register_num)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave( &priv->register_page_lock, flags );
+	if(register_num == AUXMR)
+		udelay(1);
+	nec7210_raw_write_byte(priv, iomem, data, register_num);
+	spin_unlock_irqrestore( &priv->register_page_lock, flags );
+}
+
 static inline uint8_t read_byte(nec7210_private_t *priv, unsigned int register_number)
 {
+	switch(priv->io_method)
+	{
+	case NEC7210_IO_PORT:
+		return nec7210_raw_read_byte(priv, 0, register_number);
+	case NEC7210_IO_MEM:
+		return nec7210_raw_read_byte(priv, 1, register_number);
+	case NEC7210_IO_LOCKING_PORT:
+		return nec7210_locked_read_byte(priv, 0, register_number);
+	case NEC7210_IO_LOCKING_MEM:
+		return nec7210_locked_read_byte(priv, 1, register_number);
+	default:
+		break;
+	}
 	return priv->read_byte(priv, register_number);
 }
 static inline void write_byte(nec7210_private_t *priv, uint8_t byte, unsigned int register_number)
 {
-	priv->write_byte(priv, byte, register_number);
+	int iomem = priv->io_method == NEC7210_IO_MEM;
+
+	switch(priv->io_method)
+	{
+	case NEC7210_IO_PORT:
+	case NEC7210_IO_MEM:
+		if(register_number == AUXMR)
+			nec7210_locked_write_byte(priv, iomem, byte, register_number);
+		else
+			nec7210_raw_write_byte(priv, iomem, byte, register_number);
+		break;
+	case NEC7210_IO_LOCKING_PORT:
+		nec7210_locked_write_byte(priv, 0, byte, register_number);
+		break;
+	case NEC7210_IO_LOCKING_MEM:
+		nec7210_locked_write_byte(priv, 1, byte, register_number);
+		break;
+	default:
+		priv->write_byte(priv, byte, register_number);
+		break;
+	}
 }
 
 // nec7210_private_t.state bit numbers
@@ -20,6 +20,8 @@
 
 #include <linux/types.h>
 #include <linux/interrupt.h>
+#include <linux/delay.h>
+#include <asm/io.h>
 #include "gpib_state_machines.h"
 #include "gpib_types.h"
 
@@ -29,6 +31,14 @@ enum tms9914_holdoff_mode
 	TMS9914_HOLDOFF_EOI,
 	TMS9914_HOLDOFF_ALL,
 };
+/* how read_byte() and write_byte() reach the chip, the standard methods
+ * are inlined rather than called through the hooks */
+enum tms9914_io_method
+{
+	TMS9914_IO_CUSTOM,	// through the read_byte and write_byte hooks
+	TMS9914_IO_PORT,	// inb/outb
+	TMS9914_IO_MEM,	// readb/writeb
+};
 /* struct used to provide variables local to a tms9914 chip */
 typedef struct tms9914_private_struct tms9914_private_t;
 struct tms9914_private_struct
@@ -58,22 +68,13 @@ struct tms9914_private_struct
 	unsigned holdoff_on_end : 1;
 	unsigned holdoff_on_all : 1;
 	unsigned holdoff_active : 1;
-	// wrappers for outb, inb, readb, or writeb
+	enum tms9914_io_method io_method;
+	// register access hooks, only used with TMS9914_IO_CUSTOM
 	uint8_t (*read_byte)(tms9914_private_t *priv, unsigned int register_number);
 	void (*write_byte)(tms9914_private_t *priv, uint8_t byte, unsigned int
 		register_number);
 };
 
-// slightly shorter way to access read_byte and write_byte
-static inline uint8_t read_byte(tms9914_private_t *priv, unsigned int register_number)
-{
-	return priv->read_byte(priv, register_number);
-}
-static inline void write_byte(tms9914_private_t *priv, uint8_t byte, unsigned int register_number)
-{
-	priv->write_byte(priv, byte, register_number);
-}
-
 // tms9914_private_t.state bit numbers
 enum
 {
@@ -168,6 +169,53 @@ enum
 	DIR = 7,	/* data in register            */
 };
 
+static inline uint8_t tms9914_raw_read_byte(tms9914_private_t *priv, int iomem,
+	unsigned int register_num)
+{
+	if(iomem)
+		return readb(priv->iobase + register_num * priv->offset);
+	return inb((unsigned long)(priv->iobase) + register_num * priv->offset);
+}
+static inline void tms9914_raw_write_byte(tms9914_private_t *priv, int iomem,
+	uint8_t data, unsigned int register_num)
+{
+	if(iomem)
+		writeb(data, priv->iobase + register_num * priv->offset);
+	else
+		outb(data, (unsigned long)(priv->iobase) + register_num * priv->offset);
+	if(register_num == AUXCR)
+		udelay(1);
+}
+
+static inline uint8_t read_byte(tms9914_private_t *priv, unsigned int register_number)
+{
+	switch(priv->io_method)
+	{
+	case TMS9914_IO_PORT:
+		return tms9914_raw_read_byte(priv, 0, register_number);
+	case TMS9914_IO_MEM:
+		return tms9914_raw_read_byte(priv, 1, register_number);
+	default:
+		break;
+	}
+	return priv->read_byte(priv, register_number);
+}
+static inline void write_byte(tms9914_private_t *priv, uint8_t byte, unsigned int register_number)
+{
+	switch(priv->io_method)
+	{
+	case TMS9914_IO_PORT:
+		tms9914_raw_write_byte(priv, 0, byte, register_number);
+		break;
+	case TMS9914_IO_MEM:
+		tms9914_raw_write_byte(priv, 1, byte, register_number);
+		break;
+	default:
+		priv->write_byte(priv, byte, register_number);
+		break;
+	}
+}
+
 //bit definitions common to tms9914 compatible registers
 
 /* ISR0   - Register bits */
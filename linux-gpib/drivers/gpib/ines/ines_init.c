@@ -368,8 +368,7 @@ int ines_generic_attach(gpib_board_t *board)
 		return -ENOMEM;
 	ines_priv = board->private_data;
 	nec_priv = &ines_priv->nec7210_priv;
-	nec_priv->read_byte = nec7210_ioport_read_byte;
-	nec_priv->write_byte = nec7210_ioport_write_byte;
+	nec_priv->io_method = NEC7210_IO_PORT;
 	nec_priv->offset = 1;
 	nec_priv->type = iGPIB7210;
 	ines_priv->pci_chip_type = PCI_CHIP_NONE;
@@ -79,75 +79,46 @@ void nec7210_board_online( nec7210_private_t *priv, const gpib_board_t *board )
 	write_byte( priv, AUX_PON, AUXMR);
 }
 
-/* wrappers for io */
+/* out of line versions of the inlined register access methods, for code
+ * which wants a function pointer */
 uint8_t nec7210_ioport_read_byte(nec7210_private_t *priv, unsigned int register_num)
 {
-	return inb((unsigned long)(priv->iobase) + register_num * priv->offset);
+	return nec7210_raw_read_byte(priv, 0, register_num);
 }
 void nec7210_ioport_write_byte(nec7210_private_t *priv, uint8_t data, unsigned int register_num)
 {
 	if(register_num == AUXMR)
-	{
-		/* locking makes absolutely sure noone accesses the
-		 * AUXMR register faster than once per microsecond */
-		nec7210_locking_ioport_write_byte( priv, data, register_num );
-	}else
-		outb(data, (unsigned long)(priv->iobase) + register_num * priv->offset);
+		nec7210_locked_write_byte(priv, 0, data, register_num);
+	else
+		nec7210_raw_write_byte(priv, 0, data, register_num);
 }
 uint8_t nec7210_iomem_read_byte(nec7210_private_t *priv, unsigned int register_num)
 {
-	return readb(priv->iobase + register_num * priv->offset);
+	return nec7210_raw_read_byte(priv, 1, register_num);
 }
 void nec7210_iomem_write_byte(nec7210_private_t *priv, uint8_t data, unsigned int register_num)
 {
 	if(register_num == AUXMR)
-	{
-		/* locking makes absolutely sure noone accesses the
-		 * AUXMR register faster than once per microsecond */
-		nec7210_locking_iomem_write_byte( priv, data, register_num );
-	}else
-		writeb(data, priv->iobase + register_num * priv->offset);
+		nec7210_locked_write_byte(priv, 1, data, register_num);
+	else
+		nec7210_raw_write_byte(priv, 1, data, register_num);
 }
 /* locking variants of io wrappers, for chips that page-in registers */
 uint8_t nec7210_locking_ioport_read_byte(nec7210_private_t *priv, unsigned int register_num)
 {
-	uint8_t retval;
-	unsigned long flags;
-
-	spin_lock_irqsave( &priv->register_page_lock, flags );
-	retval = inb((unsigned long)(priv->iobase) + register_num * priv->offset);
-	spin_unlock_irqrestore( &priv->register_page_lock, flags );
-	return retval;
+	return nec7210_locked_read_byte(priv, 0, register_num);
 }
 void nec7210_locking_ioport_write_byte(nec7210_private_t *priv, uint8_t data, unsigned int register_num)
 {
-	unsigned long flags;
-
-	spin_lock_irqsave( &priv->register_page_lock, flags );
-	if(register_num == AUXMR)
-		udelay(1);
-	outb(data, (unsigned long)(priv->iobase) + register_num * priv->offset);
-	spin_unlock_irqrestore( &priv->register_page_lock, flags );
+	nec7210_locked_write_byte(priv, 0, data, register_num);
 }
 uint8_t nec7210_locking_iomem_read_byte(nec7210_private_t *priv, unsigned int register_num)
 {
-	uint8_t retval;
-	unsigned long flags;
-
-	spin_lock_irqsave( &priv->register_page_lock, flags );
-	retval = readb(priv->iobase + register_num * priv->offset);
-	spin_unlock_irqrestore( &priv->register_page_lock, flags );
-	return retval;
+	return nec7210_locked_read_byte(priv, 1, register_num);
 }
 void nec7210_locking_iomem_write_byte(nec7210_private_t *priv, uint8_t data, unsigned int register_num)
 {
-	unsigned long flags;
-
-	spin_lock_irqsave( &priv->register_page_lock, flags );
-	if(register_num == AUXMR)
-		udelay(1);
-	writeb(data, priv->iobase + register_num * priv->offset);
-	spin_unlock_irqrestore( &priv->register_page_lock, flags );
+	nec7210_locked_write_byte(priv, 1, data, register_num);
 }
 
 static int __init nec7210_init_module( void )
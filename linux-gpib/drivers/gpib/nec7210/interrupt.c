@@ -54,9 +54,8 @@ irqreturn_t nec7210_interrupt( gpib_board_t *board, nec7210_private_t *priv )
 irqreturn_t nec7210_interrupt_have_status( gpib_board_t *board,
 	nec7210_private_t *priv, int status1, int status2 )
 {
-#if 0
 	unsigned long dma_flags;
-#endif
+	unsigned int wake_mask1 = priv->reg_bits[ IMR1 ];
 	int retval = IRQ_NONE;
 	
 	// record service request in status
@@ -98,21 +97,37 @@ irqreturn_t nec7210_interrupt_have_status( gpib_board_t *board,
 		if( ( priv->auxa_bits & HR_HANDSHAKE_MASK ) == HR_HLDA )
 			set_bit( RFD_HOLDOFF_BN, &priv->state);
 	}
-#if 0
 	// check for dma read transfer complete
 	if(test_bit(DMA_READ_IN_PROGRESS_BN, &priv->state))
 	{
+		int residue;
+
+		retval = IRQ_HANDLED;
+		// give the dma controller a chance to take the byte before we stop it
+		if(status1 & HR_DI)
+			udelay(1);
 		dma_flags = claim_dma_lock();
 		disable_dma(priv->dma_channel);
 		clear_dma_ff(priv->dma_channel);
-		if((status1 & HR_END) || get_dma_residue(priv->dma_channel) == 0)
+		residue = get_dma_residue(priv->dma_channel);
+		/* If the residue dropped since we last looked, the dma controller
+		 * took the byte which raised DI, and dma_read() must not read DIR
+		 * again.  Otherwise the byte is still waiting there for it. */
+		if(residue < priv->dma_read_residue)
+			clear_bit(READ_READY_BN, &priv->state);
+		priv->dma_read_residue = residue;
+		if((status1 & HR_END) || residue == 0)
 		{
 			clear_bit(DMA_READ_IN_PROGRESS_BN, &priv->state);
 		}else
+		{
+			// the dma controller takes the byte, don't wake the reader for it
+			clear_bit(READ_READY_BN, &priv->state);
+			wake_mask1 &= ~HR_DI;
 			enable_dma(priv->dma_channel);
+		}
 		release_dma_lock( dma_flags );
 	}
-#endif
 	if((status1 & HR_DO))
 	{
 		if(test_bit(DMA_WRITE_IN_PROGRESS_BN, &priv->state) == 0)
@@ -177,7 +192,7 @@ irqreturn_t nec7210_interrupt_have_status( gpib_board_t *board,
 		push_gpib_event( board, EventDevTrg );
 	}
 
-	if((status1 & priv->reg_bits[ IMR1 ]) ||
+	if((status1 & wake_mask1) ||
 		(status2 & (priv->reg_bits[ IMR2 ] & IMR2_ENABLE_INTR_MASK)) ||
 		nec7210_atn_has_changed(board, priv))
 	{
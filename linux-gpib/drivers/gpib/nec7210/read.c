@@ -19,6 +19,30 @@
 #include "board.h"
 #include <asm/dma.h>
 #include <linux/spinlock.h>
+#include <linux/module.h>
+#include <linux/string.h>
+
+/* Spins for up to board->pio_poll_usec waiting for the next byte, so a
+ * device which answers promptly doesn't cost us a sleep and wakeup for
+ * every byte.  Returns nonzero if pio_read() has something to do. */
+static int poll_for_read_byte( gpib_board_t *board, nec7210_private_t *priv )
+{
+	unsigned int i;
+
+	if( gpib_pseudo_irq_busy_poll( board ) &&
+		( test_bit(READ_READY_BN, &priv->state) ||
+		test_bit(DEV_CLEAR_BN, &priv->state) ) )
+		return 1;
+	for( i = 0; i < board->pio_poll_usec; i++ )
+	{
+		if( test_bit(READ_READY_BN, &priv->state) ||
+			test_bit(DEV_CLEAR_BN, &priv->state) ||
+			test_bit(TIMO_NUM, &board->status) )
+			return 1;
+		udelay( 1 );
+	}
+	return 0;
+}
 
 static int pio_read( gpib_board_t *board, nec7210_private_t *priv, uint8_t *buffer,
 	size_t length, int *end, size_t *bytes_read)
@@ -30,6 +54,7 @@ static int pio_read( gpib_board_t *board, nec7210_private_t *priv, uint8_t *buff
 
 	while( *bytes_read < length )
 	{
+		poll_for_read_byte( board, priv );
 		if(wait_event_interruptible(board->wait,
 			test_bit(READ_READY_BN, &priv->state) ||
 			test_bit(DEV_CLEAR_BN, &priv->state) ||
@@ -75,13 +100,32 @@ static int pio_read( gpib_board_t *board, nec7210_private_t *priv, uint8_t *buff
 	}
 	return retval;
 }
-#if 0
-static ssize_t __dma_read(gpib_board_t *board, nec7210_private_t *priv, size_t length)
+/* Reads at least this long use isa dma on boards which have a dma channel,
+ * shorter ones aren't worth programming the dma controller for. */
+static unsigned int dma_read_threshold = 64;
+module_param(dma_read_threshold, uint, 0644);
+MODULE_PARM_DESC(dma_read_threshold, "shortest read done with isa dma, 0 disables dma reads");
+
+static int dma_read_residue(nec7210_private_t *priv)
 {
-	ssize_t retval = 0;
-	size_t count = 0;
+	unsigned long dma_irq_flags;
+	int residue;
+
+	dma_irq_flags = claim_dma_lock();
+	clear_dma_ff(priv->dma_channel);
+	residue = get_dma_residue(priv->dma_channel);
+	release_dma_lock(dma_irq_flags);
+	return residue;
+}
+
+static int __dma_read(gpib_board_t *board, nec7210_private_t *priv, size_t length,
+	size_t *bytes_read)
+{
+	int retval = 0;
+	long wait_retval, poll_timeout;
 	unsigned long flags, dma_irq_flags;
 
+	*bytes_read = 0;
 	if(length == 0)
 		return 0;
 
@@ -98,6 +142,7 @@ static ssize_t __dma_read(gpib_board_t *board, nec7210_private_t *priv, size_t l
 
 	enable_dma(priv->dma_channel);
 
+	priv->dma_read_residue = length;
 	set_bit(DMA_READ_IN_PROGRESS_BN, &priv->state);
 	clear_bit(READ_READY_BN, &priv->state);
 
@@ -106,55 +151,89 @@ static ssize_t __dma_read(gpib_board_t *board, nec7210_private_t *priv, size_t l
 
 	spin_unlock_irqrestore(&board->spinlock, flags);
 
-	// wait for data to transfer
-	if(wait_event_interruptible(board->wait,
-		test_bit( DMA_READ_IN_PROGRESS_BN, &priv->state ) == 0 ||
-		test_bit( DEV_CLEAR_BN, &priv->state ) ||
-		test_bit( TIMO_NUM, &board->status ) ) )
+	/* The interrupt handler only wakes us once the transfer is done, it
+	 * checks the residue on each byte and each pseudo irq poll.  A board
+	 * without a real irq may go a while between polls, so there we also
+	 * check the residue each tick. */
+	poll_timeout = board->pseudo_irq.replaces_irq ? 1 : MAX_SCHEDULE_TIMEOUT;
+	while(1)
 	{
-		printk("nec7210: dma read wait interrupted\n");
-		retval = -ERESTARTSYS;
+		wait_retval = wait_event_interruptible_timeout(board->wait,
+			test_bit( DMA_READ_IN_PROGRESS_BN, &priv->state ) == 0 ||
+			test_bit( DEV_CLEAR_BN, &priv->state ) ||
+			test_bit( TIMO_NUM, &board->status ), poll_timeout);
+		if(wait_retval < 0)
+		{
+			GPIB_DPRINTK("nec7210: dma read wait interrupted\n");
+			retval = -ERESTARTSYS;
+			break;
+		}
+		if(wait_retval > 0 || dma_read_residue(priv) == 0)
+			break;
 	}
 	if( test_bit( TIMO_NUM, &board->status ) )
 		retval = -ETIMEDOUT;
 	if( test_bit( DEV_CLEAR_BN, &priv->state ) )
 		retval = -EINTR;
 
+	spin_lock_irqsave(&board->spinlock, flags);
 	// disable nec7210 dma
 	nec7210_set_reg_bits( priv, IMR2, HR_DMAI, 0 );
+	clear_bit(DMA_READ_IN_PROGRESS_BN, &priv->state);
 
 	// record how many bytes we transferred
-	flags = claim_dma_lock();
+	dma_irq_flags = claim_dma_lock();
 	clear_dma_ff(priv->dma_channel);
 	disable_dma(priv->dma_channel);
-	count += length - get_dma_residue(priv->dma_channel);
-	release_dma_lock(flags);
+	*bytes_read = length - get_dma_residue(priv->dma_channel);
+	release_dma_lock(dma_irq_flags);
+	spin_unlock_irqrestore(&board->spinlock, flags);
 
-	return retval ? retval : count;
+	return retval;
 }
 
-static ssize_t dma_read(gpib_board_t *board, nec7210_private_t *priv, uint8_t *buffer, size_t length)
+/* Reads through priv->dma_buffer a chunk at a time.  The chip is put in
+ * holdoff on end mode so bytes flow without a handshake release per byte,
+ * and the read stops at END the same as pio_read. */
+static int dma_read(gpib_board_t *board, nec7210_private_t *priv, uint8_t *buffer,
+	size_t length, int *end, size_t *bytes_read)
 {
-	size_t remain = length;
-	size_t transfer_size;
-	ssize_t retval = 0;
+	size_t transfer_size, num_bytes;
+	int retval = 0;
 
-	while(remain > 0)
+	*bytes_read = 0;
+	*end = 0;
+
+	/* a byte which arrived after the last read's count ran out */
+	if( test_bit( READ_READY_BN, &priv->state ) )
 	{
-		transfer_size = (priv->dma_buffer_length < remain) ? priv->dma_buffer_length : remain;
-		retval = __dma_read(board, priv, transfer_size);
-		if(retval < 0) break;
-		memcpy(buffer, priv->dma_buffer, transfer_size);
-		remain -= retval;
-		buffer += retval;
-		if(test_bit(RECEIVED_END_BN, &priv->state)) break;
+		buffer[ (*bytes_read)++ ] = nec7210_read_data_in( board, priv, end );
+		if( *end )
+			return 0;
 	}
+	nec7210_set_handshake_mode( board, priv, HR_HLDE );
+	nec7210_release_rfd_holdoff( board, priv );
 
-	if(retval < 0) return retval;
-
-	return length - remain;
+	while(*bytes_read < length)
+	{
+		transfer_size = (priv->dma_buffer_length < length - *bytes_read) ?
+			priv->dma_buffer_length : length - *bytes_read;
+		retval = __dma_read(board, priv, transfer_size, &num_bytes);
+		memcpy(&buffer[*bytes_read], priv->dma_buffer, num_bytes);
+		*bytes_read += num_bytes;
+		if(retval < 0) break;
+		/* the dma controller was stopped before it took the END byte */
+		if(test_bit( READ_READY_BN, &priv->state ) && *bytes_read < length)
+			buffer[ (*bytes_read)++ ] = nec7210_read_data_in( board, priv, end );
+		if(test_and_clear_bit( RECEIVED_END_BN, &priv->state ))
+			*end = 1;
+		if(*end) break;
+		if(need_resched())
+			schedule();
+	}
+	return retval;
 }
-#endif
+
 int nec7210_read(gpib_board_t *board, nec7210_private_t *priv, uint8_t *buffer,
 	size_t length, int *end, size_t *bytes_read)
 {
@@ -167,6 +246,10 @@ int nec7210_read(gpib_board_t *board, nec7210_private_t *priv, uint8_t *buffer,
 
 	clear_bit( DEV_CLEAR_BN, &priv->state ); // XXX wrong
 
+	if( priv->dma_channel && priv->dma_buffer && dma_read_threshold &&
+		length >= dma_read_threshold )
+		return dma_read( board, priv, buffer, length, end, bytes_read );
+
 	nec7210_release_rfd_holdoff( board, priv );
 
 	retval = pio_read(board, priv, buffer, length, end, bytes_read);
@@ -33,9 +33,50 @@ static struct usb_interface *ni_usb_driver_interfaces[MAX_NUM_NI_USB_INTERFACES]
 static int ni_usb_parse_status_block(const uint8_t *buffer, struct ni_usb_status_block *status);
 static int ni_usb_set_interrupt_monitor(gpib_board_t *board, unsigned int monitored_bits);
 static void ni_usb_stop(ni_usb_private_t *ni_priv);
+static void ni_usb_parse_ibrd_data_blocks(struct ni_usb_ibrd_parser *parser, const uint8_t *raw_data, int raw_length);
 
 static DEFINE_MUTEX(ni_usb_hotplug_lock);
 
+/* Status and bus lines are refreshed by every reply and interrupt from the
+ * adapter, this only bounds how stale lines we don't hear about can get. */
+static unsigned int status_cache_usec = 10000;
+module_param(status_cache_usec, uint, 0644);
+MODULE_PARM_DESC(status_cache_usec, "microseconds cached status and bus lines are trusted");
+
+/* Packing several ibcmd blocks into one packet hasn't been checked against
+ * real adapters yet, so it is off unless asked for. */
+static unsigned int command_blocks = 1;
+module_param(command_blocks, uint, 0644);
+MODULE_PARM_DESC(command_blocks, "ibcmd blocks of 16 command bytes sent per usb packet (1 to 8), "
+	"more than 1 is untested on hardware");
+
+static int ni_usb_cache_is_fresh(unsigned valid, ktime_t time)
+{
+	return valid && ktime_to_us(ktime_sub(ktime_get(), time)) < status_cache_usec;
+}
+
+// keeps the cached SRQ and ATN lines in step with an ibsta from the adapter
+static void ni_usb_cache_lines_from_ibsta(ni_usb_private_t *ni_priv, unsigned int ni_usb_ibsta)
+{
+	if(ni_usb_ibsta & SRQI)
+		ni_priv->cached_line_status |= BusSRQ;
+	else
+		ni_priv->cached_line_status &= ~BusSRQ;
+	if(ni_usb_ibsta & ATN)
+		ni_priv->cached_line_status |= BusATN;
+	else
+		ni_priv->cached_line_status &= ~BusATN;
+}
+
+static void ni_usb_invalidate_line_status(ni_usb_private_t *ni_priv)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&ni_priv->status_cache_lock, flags);
+	ni_priv->line_status_valid = 0;
+	spin_unlock_irqrestore(&ni_priv->status_cache_lock, flags);
+}
+
 //calculates a reasonable timeout in that can be passed to usb functions
 static inline unsigned long ni_usb_timeout_msecs(unsigned int usec)
 {
@@ -104,17 +145,12 @@ int ni_usb_nonblocking_send_bulk_msg(ni_usb_private_t *ni_priv, void *data, int
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
 		return -ENODEV;
 	}
-	if(ni_priv->bulk_urb)
+	if(ni_priv->bulk_urb_in_use)
 	{
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
 		return -EAGAIN;
 	}
-	ni_priv->bulk_urb = usb_alloc_urb(0, GFP_KERNEL);
-	if(ni_priv->bulk_urb == NULL)
-	{
-		mutex_unlock(&ni_priv->bulk_transfer_lock);
-		return -ENOMEM;
-	}
+	ni_priv->bulk_urb_in_use = 1;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
 	out_pipe = usb_sndbulkpipe(usb_dev, ni_priv->bulk_out_endpoint);
 	sema_init(&context.complete, 0);
@@ -135,8 +171,7 @@ int ni_usb_nonblocking_send_bulk_msg(ni_usb_private_t *ni_priv, void *data, int
 	{
 		if(timer_pending(&timer))
 			del_timer_sync(&timer);
-		usb_free_urb(ni_priv->bulk_urb);
-		ni_priv->bulk_urb = NULL;
+		ni_priv->bulk_urb_in_use = 0;
 		printk("%s: failed to submit bulk out urb, retval=%i\n", __FILE__, retval);
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
 		return retval;
@@ -154,8 +189,7 @@ int ni_usb_nonblocking_send_bulk_msg(ni_usb_private_t *ni_priv, void *data, int
 		del_timer_sync(&timer);
 	*actual_data_length = ni_priv->bulk_urb->actual_length;
 	mutex_lock(&ni_priv->bulk_transfer_lock);
-	usb_free_urb(ni_priv->bulk_urb);
-	ni_priv->bulk_urb = NULL;
+	ni_priv->bulk_urb_in_use = 0;
 	mutex_unlock(&ni_priv->bulk_transfer_lock);
 	return retval;
 }
@@ -193,17 +227,12 @@ int ni_usb_nonblocking_receive_bulk_msg(ni_usb_private_t *ni_priv,
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
 		return -ENODEV;
 	}
-	if(ni_priv->bulk_urb)
+	if(ni_priv->bulk_urb_in_use)
 	{
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
 		return -EAGAIN;
 	}
-	ni_priv->bulk_urb = usb_alloc_urb(0, GFP_KERNEL);
-	if(ni_priv->bulk_urb == NULL)
-	{
-		mutex_unlock(&ni_priv->bulk_transfer_lock);
-		return -ENOMEM;
-	}
+	ni_priv->bulk_urb_in_use = 1;
 	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
 	in_pipe = usb_rcvbulkpipe(usb_dev, ni_priv->bulk_in_endpoint);
 	sema_init(&context.complete, 0);
@@ -224,8 +253,7 @@ int ni_usb_nonblocking_receive_bulk_msg(ni_usb_private_t *ni_priv,
 	{
 		if(timer_pending(&timer))
 			del_timer_sync(&timer);
-		usb_free_urb(ni_priv->bulk_urb);
-		ni_priv->bulk_urb = NULL;
+		ni_priv->bulk_urb_in_use = 0;
 		printk("%s: failed to submit bulk out urb, retval=%i\n", __FILE__, retval);
 		mutex_unlock(&ni_priv->bulk_transfer_lock);
 		return retval;
@@ -259,8 +287,7 @@ int ni_usb_nonblocking_receive_bulk_msg(ni_usb_private_t *ni_priv,
 		del_timer_sync(&timer);
 	*actual_data_length = ni_priv->bulk_urb->actual_length;
 	mutex_lock(&ni_priv->bulk_transfer_lock);
-	usb_free_urb(ni_priv->bulk_urb);
-	ni_priv->bulk_urb = NULL;
+	ni_priv->bulk_urb_in_use = 0;
 	mutex_unlock(&ni_priv->bulk_transfer_lock);
 	return retval;
 }
@@ -283,6 +310,140 @@ static int ni_usb_receive_bulk_msg(ni_usb_private_t *ni_priv, void *data,
 	return retval;
 }
 
+/* Like ni_usb_nonblocking_receive_bulk_msg(), but receives into data with
+ * several urbs in flight so the host controller never runs out of queued
+ * transfers on a long read reply.  Every reply ends with a short packet, so
+ * the first urb that comes back short ends the reply and the ones queued
+ * after it are cancelled.  If parser is not NULL, the ibrd data blocks are
+ * copied out as each urb completes. */
+static int ni_usb_nonblocking_receive_bulk_stream(ni_usb_private_t *ni_priv, uint8_t *data, int data_length,
+	int *actual_data_length, int timeout_msecs, int interruptible, struct ni_usb_ibrd_parser *parser)
+{
+	struct usb_device *usb_dev;
+	int retval = 0;
+	unsigned int in_pipe;
+	ni_usb_urb_context_t context;
+	struct timer_list timer;
+	int num_urbs = (data_length + ni_usb_read_urb_length - 1) / ni_usb_read_urb_length;
+	int interrupted = 0;
+	int i;
+
+	*actual_data_length = 0;
+	if(num_urbs > ni_usb_max_read_urbs) return -EINVAL;
+	mutex_lock(&ni_priv->bulk_transfer_lock);
+	if(ni_priv->bus_interface == NULL)
+	{
+		mutex_unlock(&ni_priv->bulk_transfer_lock);
+		return -ENODEV;
+	}
+	if(ni_priv->bulk_urb_in_use)
+	{
+		mutex_unlock(&ni_priv->bulk_transfer_lock);
+		return -EAGAIN;
+	}
+	ni_priv->bulk_urb_in_use = 1;
+	usb_dev = interface_to_usbdev(ni_priv->bus_interface);
+	in_pipe = usb_rcvbulkpipe(usb_dev, ni_priv->bulk_in_endpoint);
+	sema_init(&context.complete, 0);
+	context.timed_out = 0;
+	init_timer(&timer);
+	if(timeout_msecs)
+	{
+		timer.expires = jiffies + msecs_to_jiffies(timeout_msecs);
+		timer.function = ni_usb_timeout_handler;
+		timer.data = (unsigned long) &context;
+		add_timer(&timer);
+	}
+	for(i = 0; i < num_urbs; i++)
+	{
+		int offset = i * ni_usb_read_urb_length;
+		int length = data_length - offset;
+
+		if(length > ni_usb_read_urb_length) length = ni_usb_read_urb_length;
+		usb_fill_bulk_urb(ni_priv->read_urbs[i], usb_dev, in_pipe, data + offset, length,
+			&ni_usb_bulk_complete, &context);
+		retval = usb_submit_urb(ni_priv->read_urbs[i], GFP_KERNEL);
+		if(retval)
+		{
+			printk("%s: failed to submit bulk in urb, retval=%i\n", __FILE__, retval);
+			break;
+		}
+	}
+	mutex_unlock(&ni_priv->bulk_transfer_lock);
+	if(retval)
+	{
+		num_urbs = i;
+		i = 0;
+		goto cleanup;
+	}
+	// bulk urbs on one endpoint complete in the order they were submitted
+	for(i = 0; i < num_urbs; i++)
+	{
+		struct urb *urb = ni_priv->read_urbs[i];
+
+		if(interruptible && interrupted == 0)
+		{
+			if(down_interruptible(&context.complete))
+			{
+				/* same as ni_usb_nonblocking_receive_bulk_msg(), have the
+				 * adapter finish up and send the rest of its reply now */
+				ni_usb_stop(ni_priv);
+				interrupted = 1;
+				down(&context.complete);
+			}
+		}else
+			down(&context.complete);
+		if(context.timed_out)
+		{
+			printk("%s: killing urbs due to timeout\n", __FUNCTION__);
+			retval = -ETIMEDOUT;
+			break;
+		}
+		if(urb->status)
+		{
+			retval = urb->status;
+			break;
+		}
+		*actual_data_length += urb->actual_length;
+		if(parser)
+			ni_usb_parse_ibrd_data_blocks(parser, data, *actual_data_length);
+		if(urb->actual_length < urb->transfer_buffer_length)
+		{
+			++i;
+			break;
+		}
+	}
+	if(interrupted && retval == 0)
+		retval = -ERESTARTSYS;
+cleanup:
+	for(; i < num_urbs; i++)
+		usb_kill_urb(ni_priv->read_urbs[i]);
+	if(timer_pending(&timer))
+		del_timer_sync(&timer);
+	mutex_lock(&ni_priv->bulk_transfer_lock);
+	ni_priv->bulk_urb_in_use = 0;
+	mutex_unlock(&ni_priv->bulk_transfer_lock);
+	return retval;
+}
+
+static int ni_usb_receive_bulk_stream(ni_usb_private_t *ni_priv, uint8_t *data, int data_length,
+	int *actual_data_length, int timeout_msecs, int interruptible, struct ni_usb_ibrd_parser *parser)
+{
+	int retval;
+	int timeout_msecs_remaining = timeout_msecs;
+	retval = ni_usb_nonblocking_receive_bulk_stream(ni_priv, data, data_length,
+		actual_data_length, timeout_msecs_remaining, interruptible, parser);
+	while(retval == -EAGAIN && (timeout_msecs == 0 || timeout_msecs_remaining > 0))
+	{
+		msleep(1);
+		retval = ni_usb_nonblocking_receive_bulk_stream(ni_priv, data, data_length,
+			actual_data_length, timeout_msecs_remaining, interruptible, parser);
+		if(timeout_msecs != 0) --timeout_msecs_remaining;
+	}
+	if(timeout_msecs && timeout_msecs_remaining <= 0) return -ETIMEDOUT;
+	return retval;
+}
+
 int ni_usb_receive_control_msg(ni_usb_private_t *ni_priv, __u8 request, __u8 requesttype, __u16 value, __u16 index,
 	void *data, __u16 size, int timeout_msecs)
 {
@@ -313,6 +474,11 @@ void ni_usb_soft_update_status(gpib_board_t *board, unsigned int ni_usb_ibsta, u
 	board->status &= ~clear_mask;
 	board->status &= ~ni_usb_ibsta_mask;
 	board->status |= ni_usb_ibsta & ni_usb_ibsta_mask;
+	spin_lock_irqsave(&ni_priv->status_cache_lock, flags);
+	ni_priv->status_time = ktime_get();
+	ni_priv->status_valid = 1;
+	ni_usb_cache_lines_from_ibsta(ni_priv, ni_usb_ibsta);
+	spin_unlock_irqrestore(&ni_priv->status_cache_lock, flags);
 //	if(ni_usb_ibsta & ~ni_usb_ibsta_mask)
 //	{
 //		printk("%s: debug: ibsta from ni gpib usb adapter is 0x%x\n", __FILE__, ni_usb_ibsta);
@@ -428,48 +594,79 @@ int ni_usb_parse_termination_block(const uint8_t *buffer)
 	return i;
 };
 
-int parse_board_ibrd_readback(const uint8_t *raw_data, struct ni_usb_status_block *status,
-	uint8_t *parsed_data, int parsed_data_length, int *actual_bytes_read)
+static void ni_usb_init_ibrd_parser(struct ni_usb_ibrd_parser *parser, uint8_t *parsed_data, int parsed_data_length)
+{
+	memset(parser, 0, sizeof(*parser));
+	parser->parsed_data = parsed_data;
+	parser->parsed_data_length = parsed_data_length;
+}
+
+// copies out the data blocks which have arrived completely in the first raw_length bytes of raw_data
+static void ni_usb_parse_ibrd_data_blocks(struct ni_usb_ibrd_parser *parser, const uint8_t *raw_data, int raw_length)
 {
 	static const int ibrd_data_block_length = 0xf;
 	static const int ibrd_extended_data_block_length = 0x1e;
-	int data_block_length = 0;
-	int i = 0;
-	int j = 0;
+	int i = parser->raw_offset;
 	int k;
-	unsigned int adr1_bits;
-	int num_data_blocks = 0;
-	struct ni_usb_status_block register_write_status;
-	int unexpected = 0;
 
-	while(raw_data[i] == NIUSB_IBRD_DATA_ID || raw_data[i] == NIUSB_IBRD_EXTENDED_DATA_ID)
+	while(i < raw_length && (raw_data[i] == NIUSB_IBRD_DATA_ID || raw_data[i] == NIUSB_IBRD_EXTENDED_DATA_ID))
 	{
+		int header_length;
+		int data_block_length;
+
 		if(raw_data[i] == NIUSB_IBRD_DATA_ID)
 		{
+			header_length = 1;
 			data_block_length = ibrd_data_block_length;
-		}else if(raw_data[i] == NIUSB_IBRD_EXTENDED_DATA_ID)
+		}else
 		{
+			header_length = 2;
 			data_block_length = ibrd_extended_data_block_length;
-			if(raw_data[++i] != 0)
-			{
-				printk("%s: %s: unexpected data: raw_data[%i]=0x%x, expected 0\n",
-					__FILE__, __FUNCTION__, i, (int)raw_data[i]);
-				unexpected = 1;
-			}
-		}else
+		}
+		if(i + header_length + data_block_length > raw_length) break;
+		if(header_length == 2 && raw_data[i + 1] != 0)
 		{
-			printk("%s: logic bug!\n", __FILE__);
-			return -EINVAL;
+			printk("%s: %s: unexpected data: raw_data[%i]=0x%x, expected 0\n",
+				__FILE__, __FUNCTION__, i + 1, (int)raw_data[i + 1]);
+			parser->unexpected = 1;
 		}
-		++i;
+		i += header_length;
 		for(k = 0; k < data_block_length; k++)
 		{
-			if(j < parsed_data_length)
-				parsed_data[j++] = raw_data[i++];
-			else
-				++i;
+			if(parser->parsed_offset < parser->parsed_data_length)
+				parser->parsed_data[parser->parsed_offset++] = raw_data[i];
+			++i;
 		}
-		++num_data_blocks;
+		parser->data_block_length = data_block_length;
+		++parser->num_data_blocks;
+	}
+	parser->raw_offset = i;
+}
+
+int parse_board_ibrd_readback(const uint8_t *raw_data, int raw_length, struct ni_usb_ibrd_parser *parser,
+	struct ni_usb_status_block *status, int *actual_bytes_read)
+{
+	// status, adr1 and count, register write status and termination blocks
+	static const int ibrd_trailer_length = 0x1c;
+	int i;
+	int j;
+	int k;
+	unsigned int adr1_bits;
+	int num_data_blocks;
+	int data_block_length;
+	struct ni_usb_status_block register_write_status;
+	int unexpected;
+
+	ni_usb_parse_ibrd_data_blocks(parser, raw_data, raw_length);
+	i = parser->raw_offset;
+	j = parser->parsed_offset;
+	num_data_blocks = parser->num_data_blocks;
+	data_block_length = parser->data_block_length;
+	unexpected = parser->unexpected;
+	if(raw_length - i < ibrd_trailer_length)
+	{
+		printk("%s: %s: reply truncated, %i bytes after data blocks\n", __FILE__, __FUNCTION__, raw_length - i);
+		return -EIO;
 	}
 	i += ni_usb_parse_status_block(&raw_data[i], status);
 	if(status->id != NIUSB_IBRD_STATUS_ID)
@@ -545,12 +742,13 @@ int ni_usb_write_registers(ni_usb_private_t *ni_priv, const struct ni_usb_regist
 	int reg_writes_completed;
 
 	out_data_length = num_writes * bytes_per_write + 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL)
+	if(out_data_length > ni_usb_out_buffer_length)
 	{
-		printk("%s: %s: kmalloc failed\n", __FILE__, __FUNCTION__);
-		return -ENOMEM;
+		printk("%s: %s: too many register writes (%i)\n", __FILE__, __FUNCTION__, num_writes);
+		return -EINVAL;
 	}
+	mutex_lock(&ni_priv->transfer_buffer_lock);
+	out_data = ni_priv->out_buffer;
 	i += ni_usb_bulk_register_write_header(&out_data[i], num_writes);
 	for(j = 0; j < num_writes; j++)
 	{
@@ -564,31 +762,26 @@ int ni_usb_write_registers(ni_usb_private_t *ni_priv, const struct ni_usb_regist
 		printk("%s: bug! buffer overrun\n", __FUNCTION__);
 	}
 	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
 	if(retval)
 	{
 		printk("%s: %s: ni_usb_send_bulk_msg returned %i, bytes_written=%i, i=%i\n", __FILE__, __FUNCTION__,
 			retval, bytes_written, i);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	in_data_length = 0x20;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return -ENOMEM;
-	}
+	in_data = ni_priv->in_buffer;
 	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, 1000, 0);
 	if(retval || bytes_read != 16)
 	{
 		printk("%s: %s: ni_usb_receive_bulk_msg returned %i, bytes_read=%i\n", __FILE__, __FUNCTION__, retval, bytes_read);
 		ni_usb_dump_raw_block(in_data, bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	ni_usb_parse_reg_write_status_block(in_data, &status, &reg_writes_completed);
 	//FIXME parse extra 09 status bits and termination
-	kfree(in_data);
+	mutex_unlock(&ni_priv->transfer_buffer_lock);
 	if(status.id != NIUSB_REG_WRITE_ID)
 	{
 		printk("%s: %s: parse error, id=0x%x != NIUSB_REG_WRITE_ID\n", __FILE__, __FUNCTION__, status.id);
@@ -615,7 +808,7 @@ int ni_usb_read(gpib_board_t *board, uint8_t *buffer, size_t length, int *end, s
 	int retval, parse_retval;
 	ni_usb_private_t *ni_priv = board->private_data;
 	uint8_t *out_data, *in_data;
-	int out_data_length, in_data_length;
+	int in_data_length;
 	int usb_bytes_written = 0, usb_bytes_read = 0;
 	int i = 0;
 	int complement_count;
@@ -623,6 +816,7 @@ int ni_usb_read(gpib_board_t *board, uint8_t *buffer, size_t length, int *end, s
 	struct ni_usb_status_block status;
 	static const int max_read_length = 0xffff;
 	struct ni_usb_register reg;
+	struct ni_usb_ibrd_parser parser;
 
 	*bytes_read = 0;
 	if(length > max_read_length)
@@ -630,9 +824,8 @@ int ni_usb_read(gpib_board_t *board, uint8_t *buffer, size_t length, int *end, s
 		length = max_read_length;
 		printk("%s: read length too long\n", __FILE__);
 	}
-	out_data_length = 0x20;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL) return -ENOMEM;
+	mutex_lock(&ni_priv->transfer_buffer_lock);
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = 0x0a;
 	out_data[i++] = ni_priv->eos_mode >> 8;
 	out_data[i++] = ni_priv->eos_char;
@@ -654,41 +847,41 @@ int ni_usb_read(gpib_board_t *board, uint8_t *buffer, size_t length, int *end, s
 		out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &usb_bytes_written, 1000);
-	kfree(out_data);
 	if(retval || usb_bytes_written != i)
 	{
 		if(retval == 0) retval = -EIO;
 		printk("%s: %s: ni_usb_send_bulk_msg returned %i, usb_bytes_written=%i, i=%i\n", __FILE__, __FUNCTION__, retval, usb_bytes_written, i);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	in_data_length = (length / 30 + 1) * 0x20 + 0x20;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL) return -ENOMEM;
-	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &usb_bytes_read,
-		ni_usb_timeout_msecs(board->usec_timeout), 1);
+	in_data = ni_priv->in_buffer;
+	ni_usb_init_ibrd_parser(&parser, buffer, length);
+	retval = ni_usb_receive_bulk_stream(ni_priv, in_data, in_data_length, &usb_bytes_read,
+		ni_usb_timeout_msecs(board->usec_timeout), 1, &parser);
 	if(retval == -ERESTARTSYS)
 	{}
 	else if(retval)
 	{
-		printk("%s: %s: ni_usb_receive_bulk_msg returned %i, usb_bytes_read=%i\n", 
+		printk("%s: %s: ni_usb_receive_bulk_stream returned %i, usb_bytes_read=%i\n", 
 			__FILE__, __FUNCTION__, retval, usb_bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
-	parse_retval = parse_board_ibrd_readback(in_data, &status, buffer, length, &actual_length);
+	parse_retval = parse_board_ibrd_readback(in_data, usb_bytes_read, &parser, &status, &actual_length);
 	if(parse_retval != usb_bytes_read)
 	{
 		if(parse_retval >= 0) parse_retval = -EIO;
 		printk("%s: %s: retval=%i usb_bytes_read=%i\n", __FILE__, __FUNCTION__, parse_retval, usb_bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return parse_retval;
 	}
-	kfree(in_data);
 	if(actual_length != length - status.count)
 	{
 		printk("%s: %s: actual_length=%i expected=%li\n", __FILE__, __FUNCTION__, actual_length, (long)(length - status.count));
 		ni_usb_dump_raw_block(in_data, usb_bytes_read);
 	}
+	mutex_unlock(&ni_priv->transfer_buffer_lock);
 	switch(status.error_code)
 	{
 	case NIUSB_NO_ERROR:
@@ -725,9 +918,9 @@ static int ni_usb_write(gpib_board_t *board, uint8_t *buffer, size_t length, int
 	int retval;
 	ni_usb_private_t *ni_priv = board->private_data;
 	uint8_t *out_data, *in_data;
-	int out_data_length, in_data_length;
+	int in_data_length;
 	int usb_bytes_written = 0, usb_bytes_read = 0;
-	int i = 0, j;
+	int i = 0;
 	int complement_count;
 	struct ni_usb_status_block status;
 	static const int max_write_length = 0xffff;
@@ -739,9 +932,8 @@ static int ni_usb_write(gpib_board_t *board, uint8_t *buffer, size_t length, int
 		send_eoi = 0;
 		printk("%s: write length too long\n", __FILE__);
 	}
-	out_data_length = length + 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL) return -ENOMEM;
+	mutex_lock(&ni_priv->transfer_buffer_lock);
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = 0x0d;
 	complement_count = length;
 	complement_count = length - 1;
@@ -756,32 +948,31 @@ static int ni_usb_write(gpib_board_t *board, uint8_t *buffer, size_t length, int
 	else
 		out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
-	for(j = 0; j < length; j++)
-		out_data[i++] = buffer[j];
+	memcpy(&out_data[i], buffer, length);
+	i += length;
 	while(i % 4)	// pad with zeros to 4-byte boundary
 		out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &usb_bytes_written,
 		ni_usb_timeout_msecs(board->usec_timeout));
-	kfree(out_data);
 	if(retval || usb_bytes_written != i)
 	{
 		printk("%s: %s: ni_usb_send_bulk_msg returned %i, usb_bytes_written=%i, i=%i\n", __FILE__, __FUNCTION__, retval, usb_bytes_written, i);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	in_data_length = 0x10;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL) return -ENOMEM;
+	in_data = ni_priv->in_buffer;
 	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &usb_bytes_read,
 		ni_usb_timeout_msecs(board->usec_timeout), 1);
 	if((retval && retval != -ERESTARTSYS) || usb_bytes_read != 12)
 	{
 		printk("%s: %s: ni_usb_receive_bulk_msg returned %i, usb_bytes_read=%i\n", __FILE__, __FUNCTION__, retval, usb_bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	ni_usb_parse_status_block(in_data, &status);
-	kfree(in_data);
+	mutex_unlock(&ni_priv->transfer_buffer_lock);
 	switch(status.error_code)
 	{
 	case NIUSB_NO_ERROR:
@@ -810,38 +1001,57 @@ static int ni_usb_write(gpib_board_t *board, uint8_t *buffer, size_t length, int
 	return retval;
 }
 
+/* Sends up to command_blocks ibcmd blocks in one bulk out packet.  The usb-b
+ * refuses more than 16 command bytes per ibcmd block.  Sending several
+ * blocks at once assumes the adapter replies with a status block for each,
+ * which is unverified, so by default each packet holds a single block. */
 int ni_usb_command_chunk(gpib_board_t *board, uint8_t *buffer, size_t length, size_t *command_bytes_written)
 {
 	int retval;
 	ni_usb_private_t *ni_priv = board->private_data;
 	uint8_t *out_data, *in_data;
-	int out_data_length, in_data_length;
+	int in_data_length;
 	int bytes_written = 0, bytes_read = 0;
 	int i = 0, j;
+	int block, num_blocks, num_status_blocks;
+	size_t block_lengths[ni_usb_max_command_blocks];
+	size_t offset;
+	unsigned int max_blocks = command_blocks;
+	unsigned long timeout_msecs;
 	unsigned complement_count;
 	struct ni_usb_status_block status;
 	// usb-b gives error 4 if you try to send more than 16 command bytes at once
 	static const int max_command_length = 0x10;
 
 	*command_bytes_written = 0;
-	if(length > max_command_length) length = max_command_length;
-	out_data_length = length + 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL) return -ENOMEM;
-	out_data[i++] = 0x0c;
-	complement_count = length - 1;
-	complement_count = ~complement_count;
-	out_data[i++] = complement_count;
-	out_data[i++] = 0x0;
-	out_data[i++] = ni_usb_timeout_code(board->usec_timeout);
-	for(j = 0; j < length; j++)
-		out_data[i++] = buffer[j];
-	while(i % 4)	// pad with zeros to 4-byte boundary
+	if(max_blocks < 1)
+		max_blocks = 1;
+	else if(max_blocks > ni_usb_max_command_blocks)
+		max_blocks = ni_usb_max_command_blocks;
+	if(length > max_command_length * max_blocks)
+		length = max_command_length * max_blocks;
+	num_blocks = (length + max_command_length - 1) / max_command_length;
+	mutex_lock(&ni_priv->transfer_buffer_lock);
+	out_data = ni_priv->out_buffer;
+	for(block = 0, offset = 0; block < num_blocks; block++)
+	{
+		block_lengths[block] = length - offset;
+		if(block_lengths[block] > max_command_length) block_lengths[block] = max_command_length;
+		out_data[i++] = 0x0c;
+		complement_count = block_lengths[block] - 1;
+		complement_count = ~complement_count;
+		out_data[i++] = complement_count;
 		out_data[i++] = 0x0;
+		out_data[i++] = ni_usb_timeout_code(board->usec_timeout);
+		for(j = 0; j < block_lengths[block]; j++)
+			out_data[i++] = buffer[offset++];
+		while(i % 4)	// pad with zeros to 4-byte boundary
+			out_data[i++] = 0x0;
+	}
 	i += ni_usb_bulk_termination(&out_data[i]);
-	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written,
-		ni_usb_timeout_msecs(board->usec_timeout));
-	kfree(out_data);
+	// each block can take up to the full timeout on the adapter
+	timeout_msecs = ni_usb_timeout_msecs(board->usec_timeout) * num_blocks;
+	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, timeout_msecs);
 	if(retval || bytes_written != i)
 	{
 		int k;
@@ -852,22 +1062,32 @@ int ni_usb_command_chunk(gpib_board_t *board, uint8_t *buffer, size_t length, si
 			printk(" 0x%2x", buffer[k]);
 		}
 		printk("\n");
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
-	in_data_length = 0x10;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL) return -ENOMEM;
-	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read,
-		ni_usb_timeout_msecs(board->usec_timeout), 1);
-	if((retval && retval != -ERESTARTSYS) || bytes_read != 12)
+	// a status block per ibcmd block, then the termination block
+	in_data_length = num_blocks * 8 + 8;
+	in_data = ni_priv->in_buffer;
+	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, timeout_msecs, 1);
+	num_status_blocks = (bytes_read - 4) / 8;
+	if((retval && retval != -ERESTARTSYS) || bytes_read % 8 != 4 ||
+		num_status_blocks < 1 || num_status_blocks > num_blocks)
 	{
+		if(retval == 0) retval = -EIO;
 		printk("%s: %s: ni_usb_receive_bulk_msg returned %i, bytes_read=%i\n", __FILE__, __FUNCTION__, retval, bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
-	ni_usb_parse_status_block(in_data, &status);
-	kfree(in_data);
-	*command_bytes_written = length - status.count;
+	/* stop counting at the first block which did not go out completely,
+	 * its status is the one that gets reported */
+	for(block = 0; block < num_status_blocks; block++)
+	{
+		ni_usb_parse_status_block(&in_data[block * 8], &status);
+		*command_bytes_written += block_lengths[block] - status.count;
+		if(status.error_code != NIUSB_NO_ERROR || status.count)
+			break;
+	}
+	mutex_unlock(&ni_priv->transfer_buffer_lock);
 	switch(status.error_code)
 	{
 	case NIUSB_NO_ERROR:
@@ -912,18 +1132,13 @@ int ni_usb_take_control(gpib_board_t *board, int synchronous)
 	int retval;
 	ni_usb_private_t *ni_priv = board->private_data;
 	uint8_t *out_data, *in_data;
-	int out_data_length, in_data_length;
+	int in_data_length;
 	int bytes_written = 0, bytes_read = 0;
 	int i = 0;
 	struct ni_usb_status_block status;
 
-	out_data_length = 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return -ENOMEM;
-	}
+	mutex_lock(&ni_priv->transfer_buffer_lock);
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = NIUSB_IBCAC_ID;
 	if(synchronous)
 		out_data[i++] = 0x1;
@@ -933,29 +1148,24 @@ int ni_usb_take_control(gpib_board_t *board, int synchronous)
 	out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
 	if(retval || bytes_written != i)
 	{
 		printk("%s: %s: ni_usb_send_bulk_msg returned %i, bytes_written=%i, i=%i\n", __FILE__, __FUNCTION__, retval, bytes_written, i);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	in_data_length = 0x10;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return -ENOMEM;
-	}
+	in_data = ni_priv->in_buffer;
 	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, 1000, 1);
 	if((retval && retval != -ERESTARTSYS) || bytes_read != 12)
 	{
 		if(retval == 0) retval = -EIO;
 		printk("%s: %s: ni_usb_receive_bulk_msg returned %i, bytes_read=%i\n", __FILE__, __FUNCTION__, retval, bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	ni_usb_parse_status_block(in_data, &status);
-	kfree(in_data);
+	mutex_unlock(&ni_priv->transfer_buffer_lock);
 	ni_usb_soft_update_status(board, status.ibsta, 0);
 	return retval;
 }
@@ -964,46 +1174,36 @@ int ni_usb_go_to_standby(gpib_board_t *board)
 	int retval;
 	ni_usb_private_t *ni_priv = board->private_data;
 	uint8_t *out_data, *in_data;
-	int out_data_length, in_data_length;
+	int in_data_length;
 	int bytes_written = 0, bytes_read = 0;
 	int i = 0;
 	struct ni_usb_status_block status;
 
-	out_data_length = 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return -ENOMEM;
-	}
+	mutex_lock(&ni_priv->transfer_buffer_lock);
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = NIUSB_IBGTS_ID;
 	out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
 	if(retval || bytes_written != i)
 	{
 		printk("%s: %s: ni_usb_send_bulk_msg returned %i, bytes_written=%i, i=%i\n", __FILE__, __FUNCTION__, retval, bytes_written, i);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	in_data_length = 0x20;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return -ENOMEM;
-	}
+	in_data = ni_priv->in_buffer;
 	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, 1000, 0);
 	if(retval || bytes_read != 12)
 	{
 		printk("%s: %s: ni_usb_receive_bulk_msg returned %i, bytes_read=%i\n", __FILE__, __FUNCTION__, retval, bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	ni_usb_parse_status_block(in_data, &status);
-	kfree(in_data);
+	mutex_unlock(&ni_priv->transfer_buffer_lock);
 	if(status.id != NIUSB_IBGTS_ID)
 	{
 		printk("%s: %s: bug: status.id 0x%x != INUSB_IBGTS_ID\n", __FILE__, __FUNCTION__, status.id);
@@ -1064,48 +1264,39 @@ void ni_usb_interface_clear(gpib_board_t *board, int assert)
 	int retval;
 	ni_usb_private_t *ni_priv = board->private_data;
 	uint8_t *out_data, *in_data;
-	int out_data_length, in_data_length;
+	int in_data_length;
 	int bytes_written = 0, bytes_read = 0;
 	int i = 0;
 	struct ni_usb_status_block status;
 
 	// FIXME: we are going to pulse when assert is true, and ignore otherwise
 	if(assert == 0) return;
-	out_data_length = 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return;
-	}
+	ni_usb_invalidate_line_status(ni_priv);
+	mutex_lock(&ni_priv->transfer_buffer_lock);
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = NIUSB_IBSIC_ID;
 	out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
 	if(retval || bytes_written != i)
 	{
 		printk("%s: %s: ni_usb_send_bulk_msg returned %i, bytes_written=%i, i=%i\n", __FILE__, __FUNCTION__, retval, bytes_written, i);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return;
 	}
 	in_data_length = 0x10;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return;
-	}
+	in_data = ni_priv->in_buffer;
 	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, 1000, 0);
 	if(retval || bytes_read != 12)
 	{
 		printk("%s: %s: ni_usb_receive_bulk_msg returned %i, bytes_read=%i\n", __FILE__, __FUNCTION__, retval, bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return;
 	}
 	ni_usb_parse_status_block(in_data, &status);
-	kfree(in_data);
+	mutex_unlock(&ni_priv->transfer_buffer_lock);
 	ni_usb_soft_update_status(board, status.ibsta, 0);
 	return;
 }
@@ -1116,6 +1307,7 @@ void ni_usb_remote_enable(gpib_board_t *board, int enable)
 	struct ni_usb_register reg;
 	unsigned int ibsta;
 
+	ni_usb_invalidate_line_status(ni_priv);
 	reg.device = NIUSB_SUBDEV_TNT4882;
 	reg.address = nec7210_to_tnt4882_offset(AUXMR);
 	if(enable)
@@ -1164,6 +1356,17 @@ unsigned int ni_usb_update_status( gpib_board_t *board, unsigned int clear_mask
 	static const int bufferLength = 8;
 	uint8_t *buffer;
 	struct ni_usb_status_block status;
+	unsigned long flags;
+	int fresh;
+
+	spin_lock_irqsave(&ni_priv->status_cache_lock, flags);
+	fresh = ni_usb_cache_is_fresh(ni_priv->status_valid, ni_priv->status_time);
+	spin_unlock_irqrestore(&ni_priv->status_cache_lock, flags);
+	if(fresh)
+	{
+		board->status &= ~clear_mask;
+		return board->status;
+	}
 
 	//printk("%s: receive control pipe is %i\n", __FILE__, pipe);
 	buffer = kmalloc(bufferLength, GFP_KERNEL);
@@ -1294,49 +1497,39 @@ int ni_usb_parallel_poll(gpib_board_t *board, uint8_t *result)
 	int retval;
 	ni_usb_private_t *ni_priv = board->private_data;
 	uint8_t *out_data, *in_data;
-	int out_data_length, in_data_length;
+	int in_data_length;
 	int bytes_written = 0, bytes_read = 0;
 	int i = 0;
 	int j = 0;
 	struct ni_usb_status_block status;
 
-	out_data_length = 0x10;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return -ENOMEM;
-	}
+	mutex_lock(&ni_priv->transfer_buffer_lock);
+	out_data = ni_priv->out_buffer;
 	out_data[i++] = NIUSB_IBRPP_ID;
 	out_data[i++] = 0xf0;	//FIXME: this should be the parallel poll timeout code
 	out_data[i++] = 0x0;
 	out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 	retval = ni_usb_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000 /*FIXME: should use parallel poll timeout (not supported yet)*/);
-	kfree(out_data);
 	if(retval || bytes_written != i)
 	{
 		printk("%s: %s: ni_usb_send_bulk_msg returned %i, bytes_written=%i, i=%i\n", __FILE__, __FUNCTION__, retval, bytes_written, i);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	in_data_length = 0x20;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return -ENOMEM;
-	}
+	in_data = ni_priv->in_buffer;
 	retval = ni_usb_receive_bulk_msg(ni_priv, in_data, in_data_length, 
 		&bytes_read, 1000 /*FIXME: should use parallel poll timeout (not supported yet)*/, 1);
 	if(retval && retval != -ERESTARTSYS)
 	{
 		printk("%s: %s: ni_usb_receive_bulk_msg returned %i, bytes_read=%i\n", __FILE__, __FUNCTION__, retval, bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	j += ni_usb_parse_status_block(in_data, &status);
 	*result = in_data[j++];
-	kfree(in_data);
+	mutex_unlock(&ni_priv->transfer_buffer_lock);
 	ni_usb_soft_update_status(board, status.ibsta, 0);
 	return retval;
 }
@@ -1436,46 +1629,47 @@ int ni_usb_line_status( const gpib_board_t *board )
 	int retval;
 	ni_usb_private_t *ni_priv = board->private_data;
 	uint8_t *out_data, *in_data;
-	int out_data_length, in_data_length;
+	int in_data_length;
 	int bytes_written = 0, bytes_read = 0;
 	int i = 0;
 	unsigned int bsr_bits;
 	int line_status = ValidALL;
+	unsigned long flags;
+	int fresh;
 	// NI windows driver reads 0xd(HSSEL), 0xc (ARD0), 0x1f (BSR)
 
-	out_data_length = 0x20;
-	out_data = kmalloc(out_data_length, GFP_KERNEL);
-	if(out_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return -ENOMEM;
-	}
+	spin_lock_irqsave(&ni_priv->status_cache_lock, flags);
+	fresh = ni_usb_cache_is_fresh(ni_priv->line_status_valid, ni_priv->line_status_time);
+	if(fresh)
+		line_status = ni_priv->cached_line_status;
+	spin_unlock_irqrestore(&ni_priv->status_cache_lock, flags);
+	if(fresh)
+		return line_status;
+
+	/* don't wait for a transfer in progress, like the nonblocking send below */
+	if(!mutex_trylock(&ni_priv->transfer_buffer_lock)) return -EAGAIN;
+	out_data = ni_priv->out_buffer;
 	i += ni_usb_bulk_register_read_header(&out_data[i], 1);
 	i += ni_usb_bulk_register_read(&out_data[i], NIUSB_SUBDEV_TNT4882, BSR);
 	while(i % 4)
 		out_data[i++] = 0x0;
 	i += ni_usb_bulk_termination(&out_data[i]);
 	retval = ni_usb_nonblocking_send_bulk_msg(ni_priv, out_data, i, &bytes_written, 1000);
-	kfree(out_data);
 	if(retval || bytes_written != i)
 	{
 		if(retval != -EAGAIN)
 			printk("%s: %s: ni_usb_send_bulk_msg returned %i, bytes_written=%i, i=%i\n", __FILE__, __FUNCTION__, retval, bytes_written, i);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 	in_data_length = 0x20;
-	in_data = kmalloc(in_data_length, GFP_KERNEL);
-	if(in_data == NULL)
-	{
-		printk("%s: kmalloc failed\n", __FILE__);
-		return -ENOMEM;
-	}
+	in_data = ni_priv->in_buffer;
 	retval = ni_usb_nonblocking_receive_bulk_msg(ni_priv, in_data, in_data_length, &bytes_read, 1000, 0);
 	if(retval)
 	{
 		if(retval != -EAGAIN)
 			printk("%s: %s: ni_usb_receive_bulk_msg returned %i, bytes_read=%i\n", __FILE__, __FUNCTION__, retval, bytes_read);
-		kfree(in_data);
+		mutex_unlock(&ni_priv->transfer_buffer_lock);
 		return retval;
 	}
 #if 0
@@ -1505,6 +1699,11 @@ printk("\n");
 		line_status |= BusDAV;
 	if(bsr_bits & BCSR_ATN_BIT)
 		line_status |= BusATN;
+	spin_lock_irqsave(&ni_priv->status_cache_lock, flags);
+	ni_priv->cached_line_status = line_status;
+	ni_priv->line_status_time = ktime_get();
+	ni_priv->line_status_valid = 1;
+	spin_unlock_irqrestore(&ni_priv->status_cache_lock, flags);
 	return line_status;
 }
 unsigned int ni_usb_t1_delay( gpib_board_t *board, unsigned int nano_sec )
@@ -1556,6 +1755,7 @@ unsigned int ni_usb_t1_delay( gpib_board_t *board, unsigned int nano_sec )
 static int ni_usb_allocate_private(gpib_board_t *board)
 {
 	ni_usb_private_t *ni_priv;
+	int i;
 
 	board->private_data = kmalloc(sizeof(ni_usb_private_t), GFP_KERNEL);
 	if(board->private_data == NULL)
@@ -1565,13 +1765,39 @@ static int ni_usb_allocate_private(gpib_board_t *board)
 	mutex_init(&ni_priv->bulk_transfer_lock);
 	mutex_init(&ni_priv->control_transfer_lock);
 	mutex_init(&ni_priv->interrupt_transfer_lock);
+	mutex_init(&ni_priv->transfer_buffer_lock);
+	spin_lock_init(&ni_priv->status_cache_lock);
+	ni_priv->bulk_urb = usb_alloc_urb(0, GFP_KERNEL);
+	if(ni_priv->bulk_urb == NULL)
+		return -ENOMEM;
+	for(i = 0; i < ni_usb_max_read_urbs; i++)
+	{
+		ni_priv->read_urbs[i] = usb_alloc_urb(0, GFP_KERNEL);
+		if(ni_priv->read_urbs[i] == NULL)
+			return -ENOMEM;
+	}
+	ni_priv->out_buffer = kmalloc(ni_usb_out_buffer_length, GFP_KERNEL);
+	if(ni_priv->out_buffer == NULL)
+		return -ENOMEM;
+	ni_priv->in_buffer = kmalloc(ni_usb_in_buffer_length, GFP_KERNEL);
+	if(ni_priv->in_buffer == NULL)
+		return -ENOMEM;
 	return 0;
 }
 
 static void ni_usb_free_private(ni_usb_private_t *ni_priv)
 {
+	int i;
+
 	if(ni_priv->interrupt_urb)
 		usb_free_urb(ni_priv->interrupt_urb);
+	if(ni_priv->bulk_urb)
+		usb_free_urb(ni_priv->bulk_urb);
+	for(i = 0; i < ni_usb_max_read_urbs; i++)
+		if(ni_priv->read_urbs[i])
+			usb_free_urb(ni_priv->read_urbs[i]);
+	kfree(ni_priv->out_buffer);
+	kfree(ni_priv->in_buffer);
 	kfree(ni_priv);
 	return;
 }
@@ -1724,6 +1950,13 @@ void ni_usb_interrupt_complete(struct urb *urb PT_REGS_ARG)
 // 	printk("debug: monitored_ibsta_bits=0x%x\n", ni_priv->monitored_ibsta_bits);
 	spin_unlock_irqrestore(&board->spinlock, flags);
 
+	/* a monitored bit changed, so make the next update_status ask the
+	 * adapter (which also rearms the monitor) */
+	spin_lock_irqsave(&ni_priv->status_cache_lock, flags);
+	ni_priv->status_valid = 0;
+	ni_usb_cache_lines_from_ibsta(ni_priv, status.ibsta);
+	spin_unlock_irqrestore(&ni_priv->status_cache_lock, flags);
+
 	retval = usb_submit_urb(ni_priv->interrupt_urb, GFP_ATOMIC);
 	if(retval)
 	{
@@ -1799,12 +2032,17 @@ static int ni_usb_setup_urbs(gpib_board_t *board)
 
 static void ni_usb_cleanup_urbs(ni_usb_private_t *ni_priv)
 {
+	int i;
+
 	if(ni_priv && ni_priv->bus_interface)
 	{
 		if(ni_priv->interrupt_urb)
 			usb_kill_urb(ni_priv->interrupt_urb);
 		if(ni_priv->bulk_urb)
 			usb_kill_urb(ni_priv->bulk_urb);
+		for(i = 0; i < ni_usb_max_read_urbs; i++)
+			if(ni_priv->read_urbs[i])
+				usb_kill_urb(ni_priv->read_urbs[i]);
 	}
 };
 
@@ -2175,6 +2413,11 @@ gpib_interface_t ni_usb_gpib_interface =
 	serial_poll_status: ni_usb_serial_poll_status,
 	t1_delay: ni_usb_t1_delay,
 	return_to_local: ni_usb_return_to_local,
+	caps:
+	{
+		max_transfer_length: 0xffff,
+		status_has_srqi: 1,
+	},
 };
 
 // Table with the USB-devices: just now only testing IDs
@@ -63,6 +63,20 @@ enum hs_enpoint_addresses
 	NIUSB_HS_INTERRUPT_IN_ENDPOINT = 0x1,
 };
 
+enum ni_usb_buffer_lengths
+{
+	// largest packet we send, a write of 0xffff bytes plus header and termination
+	ni_usb_out_buffer_length = 0xffff + 0x10,
+	// largest reply, a read of 0xffff bytes comes back in blocks of 30 with 2 byte headers
+	ni_usb_in_buffer_length = (0xffff / 30 + 1) * 0x20 + 0x20,
+	/* read replies are received by several urbs of this size in flight at
+	 * once, it is a multiple of both the full and high speed max packet size */
+	ni_usb_read_urb_length = 0x4000,
+	ni_usb_max_read_urbs = (ni_usb_in_buffer_length + ni_usb_read_urb_length - 1) / ni_usb_read_urb_length,
+	// most ibcmd blocks of 16 command bytes packed into one bulk out packet
+	ni_usb_max_command_blocks = 8,
+};
+
 // struct which defines private_data for ni_usb devices
 typedef struct
 {
@@ -73,12 +87,29 @@ typedef struct
 	uint8_t eos_char;
 	unsigned short eos_mode;
 	unsigned int monitored_ibsta_bits;
+	/* allocated at attach and reused for every bulk transfer */
 	struct urb *bulk_urb;
+	struct urb *read_urbs[ni_usb_max_read_urbs];
+	unsigned bulk_urb_in_use : 1;
 	struct urb *interrupt_urb;
 	uint8_t interrupt_buffer[0x11];
+	/* request and reply packets are built and parsed in place here,
+	 * transfer_buffer_lock is held from building a request until its reply
+	 * has been parsed */
+	uint8_t *out_buffer;
+	uint8_t *in_buffer;
+	struct mutex transfer_buffer_lock;
 	struct mutex bulk_transfer_lock;
 	struct mutex control_transfer_lock;
 	struct mutex interrupt_transfer_lock;
+	/* board->status and bus line state as of the last reply or interrupt,
+	 * so status queries don't need a round trip to the adapter */
+	spinlock_t status_cache_lock;
+	ktime_t status_time;
+	ktime_t line_status_time;
+	int cached_line_status;
+	unsigned status_valid : 1;
+	unsigned line_status_valid : 1;
 } ni_usb_private_t;
 
 typedef struct
@@ -87,6 +118,18 @@ typedef struct
 	unsigned timed_out : 1;
 } ni_usb_urb_context_t;
 
+// state for copying out the data of an ibrd reply while the rest of it is still arriving
+struct ni_usb_ibrd_parser
+{
+	uint8_t *parsed_data;
+	int parsed_data_length;
+	int raw_offset;
+	int parsed_offset;
+	int num_data_blocks;
+	int data_block_length;
+	unsigned unexpected : 1;
+};
+
 struct ni_usb_status_block
 {
 	short id;
@@ -284,8 +284,7 @@ int pc2_generic_attach(gpib_board_t *board, enum nec7210_chipset chipset)
 		return -ENOMEM;
 	pc2_priv = board->private_data;
 	nec_priv = &pc2_priv->nec7210_priv;
-	nec_priv->read_byte = nec7210_ioport_read_byte;
-	nec_priv->write_byte = nec7210_ioport_write_byte;
+	nec_priv->io_method = NEC7210_IO_PORT;
 	nec_priv->type = chipset;
 	if(board->ibdma)
 	{
@@ -339,7 +338,9 @@ int pc2_attach(gpib_board_t *board, gpib_board_config_t config)
 		}
 	}
 	pc2_priv->irq = board->ibirq;
-	/* poll so we can detect assertion of ATN */
+	/* poll so we can detect assertion of ATN, and for everything else
+	 * if we have no irq */
+	board->pseudo_irq.replaces_irq = pc2_priv->irq == 0;
 	if(gpib_request_pseudo_irq(board, pc2_interrupt))
 	{
 		printk("pc2_gpib: failed to allocate pseudo_irq\n");
@@ -468,7 +469,9 @@ int pc2a_common_attach(gpib_board_t *board, unsigned int num_registers, enum nec
 		}
 	}
 	pc2_priv->irq = board->ibirq;
-	/* poll so we can detect assertion of ATN */
+	/* poll so we can detect assertion of ATN, and for everything else
+	 * if we have no irq */
+	board->pseudo_irq.replaces_irq = pc2_priv->irq == 0;
 	if(gpib_request_pseudo_irq(board, pc2_interrupt))
 	{
 		printk("pc2_gpib: failed to allocate pseudo_irq\n");
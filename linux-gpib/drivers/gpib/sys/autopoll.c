@@ -27,31 +27,24 @@ unsigned int num_status_bytes( const gpib_status_queue_t *dev )
 }
 
 // push status byte onto back of status byte fifo
-int push_status_byte( gpib_status_queue_t *device, uint8_t poll_byte )
+int push_status_byte( gpib_board_t *board, gpib_status_queue_t *device, uint8_t poll_byte )
 {
-	struct list_head *head = &device->status_bytes;
-	status_byte_t *status;
-	static const unsigned int max_num_status_bytes = 1024;
-	int retval;
-
-	if( num_status_bytes( device ) >= max_num_status_bytes )
+	spin_lock( &board->status_queue_lock );
+	if( num_status_bytes( device ) >= device->size )
 	{
-		uint8_t lost_byte;
-
 		device->dropped_byte = 1;
-		retval = pop_status_byte( device, &lost_byte );
-		if( retval < 0 ) return retval;
+		if( device->drop_newest )
+		{
+			spin_unlock( &board->status_queue_lock );
+			return 0;
+		}
+		device->front = ( device->front + 1 ) % device->size;
+		device->num_status_bytes--;
 	}
 
-	status = kmalloc( sizeof( status_byte_t ), GFP_KERNEL );
-	if( status == NULL ) return -ENOMEM;
-
-	INIT_LIST_HEAD( &status->list );
-	status->poll_byte = poll_byte;
-
-	list_add_tail( &status->list, head );
-
+	device->status_bytes[ ( device->front + device->num_status_bytes ) % device->size ] = poll_byte;
 	device->num_status_bytes++;
+	spin_unlock( &board->status_queue_lock );
 
 	GPIB_DPRINTK( "pushed status byte 0x%x, %i in queue\n",
 		(int) poll_byte, num_status_bytes( device ) );
@@ -60,29 +53,26 @@ int push_status_byte( gpib_status_queue_t *device, uint8_t poll_byte )
 }
 
 // pop status byte from front of status byte fifo
-int pop_status_byte( gpib_status_queue_t *device, uint8_t *poll_byte )
+int pop_status_byte( gpib_board_t *board, gpib_status_queue_t *device, uint8_t *poll_byte )
 {
-	struct list_head *head = &device->status_bytes;
-	struct list_head *front = head->next;
-	status_byte_t *status;
-
-	if( num_status_bytes( device ) == 0 ) return -EIO;
-
-	if( front == head ) return -EIO;
+	spin_lock( &board->status_queue_lock );
+	if( num_status_bytes( device ) == 0 )
+	{
+		spin_unlock( &board->status_queue_lock );
+		return -EIO;
+	}
 
 	if( device->dropped_byte )
 	{
 		device->dropped_byte = 0;
+		spin_unlock( &board->status_queue_lock );
 		return -EPIPE;
 	}
 
-	status = list_entry( front, status_byte_t, list );
-	*poll_byte = status->poll_byte;
-
-	list_del( front );
-	kfree( status );
-
+	*poll_byte = device->status_bytes[ device->front ];
+	device->front = ( device->front + 1 ) % device->size;
 	device->num_status_bytes--;
+	spin_unlock( &board->status_queue_lock );
 
 	GPIB_DPRINTK( "popped status byte 0x%x, %i in queue\n",
 		(int) *poll_byte, num_status_bytes( device ) );
@@ -90,20 +80,63 @@ int pop_status_byte( gpib_status_queue_t *device, uint8_t *poll_byte )
 	return 0;
 }
 
+static inline unsigned int device_table_column( int sad )
+{
+	if( sad < 0 ) return 0;
+	return sad + 1;
+}
+
 gpib_status_queue_t * get_gpib_status_queue( gpib_board_t *board, unsigned int pad, int sad )
 {
-	gpib_status_queue_t *device;
-	struct list_head *list_ptr;
-	const struct list_head *head = &board->device_list;
+	gpib_status_queue_t **row;
+
+	if( pad > gpib_addr_max || sad > gpib_addr_max ) return NULL;
+	row = board->device_table[ pad ];
+	if( row == NULL ) return NULL;
+	return row[ device_table_column( sad ) ];
+}
 
-	for( list_ptr = head->next; list_ptr != head; list_ptr = list_ptr->next )
+// add a newly opened device to board's device list and table
+int insert_gpib_status_queue( gpib_board_t *board, gpib_status_queue_t *device )
+{
+	gpib_status_queue_t **row;
+
+	if( device->pad > gpib_addr_max || device->sad > gpib_addr_max ) return -EINVAL;
+	spin_lock( &board->status_queue_lock );
+	row = board->device_table[ device->pad ];
+	if( row == NULL )
 	{
-		device = list_entry( list_ptr, gpib_status_queue_t, list );
-		if( gpib_address_equal( device->pad, device->sad, pad, sad ) )
-			return device;
+		row = kzalloc( ( GPIB_NUM_ADDRESSES + 1 ) * sizeof( *row ), GFP_ATOMIC );
+		if( row == NULL )
+		{
+			spin_unlock( &board->status_queue_lock );
+			return -ENOMEM;
+		}
+		board->device_table[ device->pad ] = row;
 	}
+	row[ device_table_column( device->sad ) ] = device;
+	list_add( &device->list, &board->device_list );
+	spin_unlock( &board->status_queue_lock );
+	return 0;
+}
 
-	return NULL;
+void remove_gpib_status_queue( gpib_board_t *board, gpib_status_queue_t *device )
+{
+	gpib_status_queue_t **row;
+	int i;
+
+	spin_lock( &board->status_queue_lock );
+	row = board->device_table[ device->pad ];
+	list_del( &device->list );
+	row[ device_table_column( device->sad ) ] = NULL;
+	for( i = 0; i <= GPIB_NUM_ADDRESSES; i++ )
+		if( row[ i ] ) break;
+	if( i > GPIB_NUM_ADDRESSES )
+		board->device_table[ device->pad ] = NULL;
+	else
+		row = NULL;
+	spin_unlock( &board->status_queue_lock );
+	kfree( row );
 }
 
 int get_serial_poll_byte( gpib_board_t *board, unsigned int pad, int sad, unsigned int usec_timeout,
@@ -117,7 +150,7 @@ int get_serial_poll_byte( gpib_board_t *board, unsigned int pad, int sad, unsign
 	device = get_gpib_status_queue( board, pad, sad );
 	if( num_status_bytes( device ) )
 	{
-		return pop_status_byte( device, poll_byte );
+		return pop_status_byte( board, device, poll_byte );
 	}else
 	{
 		return dvrsp( board, pad, sad, usec_timeout, poll_byte );
@@ -153,7 +186,7 @@ int autopoll_all_devices( gpib_board_t *board )
 	GPIB_DPRINTK( "autopoll_all_devices() complete\n" );
 	/* need to wake wait queue in case someone is
 	* waiting on RQS */
-	wake_up_interruptible( &board->wait );
+	wake_up_interruptible( &board->rqs_wait );
 	mutex_unlock(&board->big_gpib_mutex);
 	mutex_unlock( &board->user_mutex );
 
@@ -21,9 +21,11 @@
 #include "gpib_types.h"
 
 unsigned int num_status_bytes( const gpib_status_queue_t *dev );
-int push_status_byte( gpib_status_queue_t *device, uint8_t poll_byte );
-int pop_status_byte( gpib_status_queue_t *device, uint8_t *poll_byte );
+int push_status_byte( gpib_board_t *board, gpib_status_queue_t *device, uint8_t poll_byte );
+int pop_status_byte( gpib_board_t *board, gpib_status_queue_t *device, uint8_t *poll_byte );
 gpib_status_queue_t * get_gpib_status_queue( gpib_board_t *board, unsigned int pad, int sad );
+int insert_gpib_status_queue( gpib_board_t *board, gpib_status_queue_t *device );
+void remove_gpib_status_queue( gpib_board_t *board, gpib_status_queue_t *device );
 int get_serial_poll_byte( gpib_board_t *board, unsigned int pad, int sad,
 	unsigned int usec_timeout, uint8_t *poll_byte );
 int autopoll_all_devices( gpib_board_t *board );
@@ -162,7 +162,7 @@ int serial_poll_all( gpib_board_t *board, unsigned int usec_timeout )
 		if( retval < 0 ) continue;
 		if( result & request_service_bit )
 		{
-			retval = push_status_byte( device, result );
+			retval = push_status_byte( board, device, result );
 			if( retval < 0 ) continue;
 			num_bytes++;
 		}
@@ -174,6 +174,52 @@ int serial_poll_all( gpib_board_t *board, unsigned int usec_timeout )
 	return num_bytes;
 }
 
+/* Serial polls a list of addresses inside one SPE/SPD bracket.  Status bytes
+ * already queued for an address (by autopolling) are returned without
+ * touching the bus, as get_serial_poll_byte() does. */
+int serial_poll_list( gpib_board_t *board, serial_poll_ioctl_t *polls, unsigned int num_polls,
+	unsigned int usec_timeout, int stop_on_rqs, unsigned int *num_completed )
+{
+	gpib_status_queue_t *device;
+	int retval = 0;
+	int cleanup_retval;
+	int poll_enabled = 0;
+	unsigned int i;
+
+	*num_completed = 0;
+	for( i = 0; i < num_polls; i++ )
+	{
+		device = get_gpib_status_queue( board, polls[ i ].pad, polls[ i ].sad );
+		if( num_status_bytes( device ) )
+		{
+			retval = pop_status_byte( board, device, &polls[ i ].status_byte );
+		}else
+		{
+			if( poll_enabled == 0 )
+			{
+				retval = setup_serial_poll( board, usec_timeout );
+				if( retval < 0 ) break;
+				poll_enabled = 1;
+			}
+			retval = read_serial_poll_byte( board, polls[ i ].pad, polls[ i ].sad,
+				usec_timeout, &polls[ i ].status_byte );
+			if( io_timed_out( board ) ) retval = -ETIMEDOUT;
+		}
+		if( retval < 0 ) break;
+		( *num_completed )++;
+		if( stop_on_rqs && ( polls[ i ].status_byte & request_service_bit ) )
+			break;
+	}
+
+	if( poll_enabled )
+	{
+		cleanup_retval = cleanup_serial_poll( board, usec_timeout );
+		if( retval == 0 ) retval = cleanup_retval;
+	}
+
+	return retval;
+}
+
 /*
  * DVRSP
  * This function performs a serial poll of the device with primary
@@ -46,34 +46,18 @@ int push_gpib_event( gpib_board_t *board, short event_type )
 static int push_gpib_event_nolock( gpib_board_t *board, short event_type )
 {
 	gpib_event_queue_t *queue = &board->event_queue;
-	struct list_head *head = &queue->event_head;
-	gpib_event_t *event;
-	static const unsigned int max_num_events = 1024;
-	int retval;
-
-	if( num_gpib_events( queue ) >= max_num_events )
-	{
-		short lost_event;
 
-		queue->dropped_event = 1;
-		retval = pop_gpib_event_nolock( queue, &lost_event );
-		if( retval < 0 )
-			return retval;
-	}
+	if( queue->events == NULL ) return -EIO;
 
-	event = kmalloc( sizeof( gpib_event_t ), GFP_ATOMIC );
-	if( event == NULL )
+	if( num_gpib_events( queue ) >= queue->size )
 	{
 		queue->dropped_event = 1;
-		printk( "gpib: failed to allocate memory for event\n");
-		return -ENOMEM;
+		if( queue->drop_newest ) return 0;
+		queue->front = ( queue->front + 1 ) % queue->size;
+		queue->num_events--;
 	}
 
-	INIT_LIST_HEAD( &event->list );
-	event->event_type = event_type;
-
-	list_add_tail( &event->list, head );
-
+	queue->events[ ( queue->front + queue->num_events ) % queue->size ] = event_type;
 	queue->num_events++;
 
 	GPIB_DPRINTK( "pushed event %i, %i in queue\n",
@@ -96,30 +80,20 @@ int pop_gpib_event( gpib_event_queue_t *queue, short *event_type )
 
 static int pop_gpib_event_nolock( gpib_event_queue_t *queue, short *event_type )
 {
-	struct list_head *head = &queue->event_head;
-	struct list_head *front = head->next;
-	gpib_event_t *event;
-
 	if( num_gpib_events( queue ) == 0 )
 	{
 		*event_type = EventNone;
 		return 0;
 	}
 
-	if( front == head ) return -EIO;
-
 	if( queue->dropped_event )
 	{
 		queue->dropped_event = 0;
 		return -EPIPE;
 	}
 
-	event = list_entry( front, gpib_event_t, list );
-	*event_type = event->event_type;
-
-	list_del( front );
-	kfree( event );
-
+	*event_type = queue->events[ queue->front ];
+	queue->front = ( queue->front + 1 ) % queue->size;
 	queue->num_events--;
 
 	GPIB_DPRINTK( "popped event %i, %i in queue\n",
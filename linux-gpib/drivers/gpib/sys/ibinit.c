@@ -85,10 +85,12 @@ int ibonline(gpib_board_t *board, gpib_board_config_t config)
 	retval = gpib_allocate_board( board );
 	if( retval < 0 ) return retval;
 
+	down_write( &board->attach_rwsem );
 	retval = board->interface->attach(board, config);
 	if(retval < 0)
 	{
 		board->interface->detach(board);
+		up_write( &board->attach_rwsem );
 		printk("gpib: interface attach failed\n");
 		return retval;
 	}
@@ -101,10 +103,17 @@ int ibonline(gpib_board_t *board, gpib_board_config_t config)
 	{
 		printk("gpib: failed to create autospoll thread\n");
 		board->interface->detach(board);
+		up_write( &board->attach_rwsem );
 		return retval;
 	}
 #endif
 	board->online = 1;
+	up_write( &board->attach_rwsem );
+	/* attach may have changed things like the t1 delay, and the
+	 * driver starts out with its eos disabled */
+	board_info_changed( board );
+	board_timeout_changed( board );
+	board_eos_changed( board );
 	GPIB_DPRINTK( "gpib: board online\n" );
 
 	return 0;
@@ -129,9 +138,15 @@ int iboffline( gpib_board_t *board )
 		board->autospoll_task = NULL;
 	}
 
+	/* waits for status checks still using the driver */
+	down_write( &board->attach_rwsem );
 	board->interface->detach( board );
 	gpib_deallocate_board( board );
 	board->online = 0;
+	up_write( &board->attach_rwsem );
+	board_info_changed( board );
+	board_timeout_changed( board );
+	board_eos_changed( board );
 	GPIB_DPRINTK( "gpib: board offline\n" );
 
 	return 0;
@@ -51,9 +51,8 @@ int ibrd(gpib_board_t *board, uint8_t *buf, size_t length, int *end_flag, size_t
 		retval = ibgts( board );
 		if( retval < 0 ) return retval;
 	}
-	/* XXX reseting timer here could cause timeouts take longer than they should,
-	 * since read_ioctl calls this
-	 * function in a loop, there is probably a similar problem with writes/commands */
+	/* read_ioctl calls this function in a loop, but sets a deadline
+	 * so the timeout applies to the whole transfer */
 	osStartTimer( board, board->usec_timeout );
 
 	do
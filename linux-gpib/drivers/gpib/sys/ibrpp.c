@@ -48,6 +48,7 @@ int ibppc( gpib_board_t *board, uint8_t configuration )
 	configuration &= 0x1f;
 	board->interface->parallel_poll_configure( board, configuration );
 	board->parallel_poll_configuration = configuration;
+	board_info_changed( board );
 	
 	return 0;
 }
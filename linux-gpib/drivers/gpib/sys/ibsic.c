@@ -53,6 +53,7 @@ int ibsic( gpib_board_t *board, unsigned int usec_duration )
 void ibrsc( gpib_board_t *board, int request_control )
 {
 	board->master = request_control != 0;
+	board_info_changed( board );
 	if( board->interface->request_system_control == NULL )
 	{
 		printk( "gpib: bug! driver does not implement request_system_control()\n" );
@@ -18,4 +18,5 @@
 #include <asm/uaccess.h>
 
 extern int gpib_allocate_board( gpib_board_t *board );
+extern int gpib_resize_buffer( gpib_board_t *board, unsigned int length );
 extern void gpib_deallocate_board( gpib_board_t *board );
@@ -17,6 +17,7 @@ int ibpad( gpib_board_t *board, unsigned int addr )
 		board->pad = addr;
 		if( board->online )
 			board->interface->primary_address( board, board->pad );
+		board_info_changed( board );
 		GPIB_DPRINTK( "set primary addr to %i\n", board->pad );
 	}
 	return 0;
@@ -48,6 +49,7 @@ int ibsad( gpib_board_t *board, int addr )
 				board->interface->secondary_address( board, 0, 0 );
 			}
 		}
+		board_info_changed( board );
 		GPIB_DPRINTK( "set secondary addr to %i\n", board->sad );
 	}
 	return 0;
@@ -76,9 +78,57 @@ int ibeos( gpib_board_t *board, int eos, int eosflags )
 			retval = 0;
 		}
 	}
+	board_eos_changed( board );
 	return retval;
 }
 
+/* Rebuilds the board info reported by IBBOARD_INFO and invalidates any copy
+ * user space has cached.  Should be called whenever something it reports
+ * changes. */
+void board_info_changed( gpib_board_t *board )
+{
+	board_info_ioctl_t info;
+
+	memset( &info, 0, sizeof( info ) );
+	info.pad = board->pad;
+	info.sad = board->sad;
+	info.parallel_poll_configuration = board->parallel_poll_configuration;
+	info.is_system_controller = board->master;
+	if( board->autospollers )
+		info.autopolling = 1;
+	else
+		info.autopolling = 0;
+	info.t1_delay = board->t1_nano_sec;
+	info.ist = board->ist;
+	if( board->interface )
+		info.no_7_bit_eos = board->interface->no_7_bit_eos;
+	info.buffer_length = board->online ? board->buffer_length : board->initial_buffer_length;
+	info.max_buffer_length = board->max_buffer_length;
+	write_seqlock( &board->info_seqlock );
+	board->info = info;
+	write_sequnlock( &board->info_seqlock );
+
+	if( board->state_page == NULL ) return;
+	smp_wmb();
+	board->state_page->info_generation++;
+}
+
+/* Invalidates any shadow copy user space keeps of the settings last passed to
+ * IBTMO or IBEOS. */
+void board_timeout_changed( gpib_board_t *board )
+{
+	if( board->state_page == NULL ) return;
+	smp_wmb();
+	board->state_page->usec_timeout_generation++;
+}
+
+void board_eos_changed( gpib_board_t *board )
+{
+	if( board->state_page == NULL ) return;
+	smp_wmb();
+	board->state_page->eos_generation++;
+}
+
 int ibstatus( gpib_board_t *board )
 {
 	return general_ibstatus( board, NULL, 0, 0, NULL);
@@ -96,8 +146,9 @@ int general_ibstatus( gpib_board_t *board, const gpib_status_queue_t *device,
 		/* XXX should probably stop having drivers use TIMO bit in
 		 * board->status to avoid confusion */
 		status &= ~TIMO;
-		/* get real SRQI status if we can */
-		if(iblines(board, &line_status) == 0)
+		/* get real SRQI status if we can, and the driver didn't already */
+		if( board->interface->caps.status_has_srqi == 0 &&
+			iblines(board, &line_status) == 0)
 		{
 			if((line_status & ValidSRQ))
 			{
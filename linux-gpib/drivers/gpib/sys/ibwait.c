@@ -19,36 +19,70 @@
 #include "gpibP.h"
 #include "autopoll.h"
 #include <linux/sched.h>
+#include <linux/hrtimer.h>
 
 struct wait_info
 {
 	gpib_board_t *board;
-	struct timer_list timer;
+	wait_queue_head_t *wait;
+	struct hrtimer timer;
 	volatile int timed_out;
 	unsigned long usec_timeout;
 };
 
+static enum hrtimer_restart wait_timeout( struct hrtimer *timer );
+
 static void init_wait_info( struct wait_info *winfo )
 {
 	winfo->board = NULL;
-	init_timer( &winfo->timer );
+	winfo->wait = NULL;
+	/* hrtimer so short timeouts aren't rounded up to a jiffy */
+	hrtimer_init_on_stack( &winfo->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL );
+	winfo->timer.function = wait_timeout;
 	winfo->timed_out = 0;
 }
 
-static int wait_satisfied( struct wait_info *winfo, gpib_status_queue_t *status_queue,
-	int wait_mask, int *status, gpib_descriptor_t *desc )
+/* Gets the status of the board or device 'desc' refers to.  ibwait() runs
+ * without big_gpib_mutex, so status checks don't wait behind serial polls
+ * and the like.  board->attach_rwsem keeps the driver attached while we call
+ * into it, and the device's status queue is only looked at under
+ * status_queue_lock, since close_dev may free it.  The status is reported
+ * as for 'status_desc', which may be NULL. */
+static int locked_ibstatus( gpib_board_t *board, const gpib_descriptor_t *desc,
+	int clear_mask, int set_mask, gpib_descriptor_t *status_desc, int *status )
 {
-	gpib_board_t *board = winfo->board;
-	int temp_status;
+	int rqs = 0;
 
-	if(mutex_lock_interruptible( &board->big_gpib_mutex ))
+	down_read( &board->attach_rwsem );
+	if( !board->online )
 	{
-		return -ERESTARTSYS;
+		up_read( &board->attach_rwsem );
+		return -EINVAL;
 	}
 
-	temp_status = general_ibstatus( board, status_queue, 0, 0, desc );
+	if( desc->is_board == 0 )
+	{
+		spin_lock( &board->status_queue_lock );
+		if( num_status_bytes( get_gpib_status_queue( board, desc->pad, desc->sad ) ) )
+			rqs = RQS;
+		spin_unlock( &board->status_queue_lock );
+	}
+	*status = general_ibstatus( board, NULL, clear_mask, set_mask, status_desc ) | rqs;
 
-	mutex_unlock(&board->big_gpib_mutex);
+	up_read( &board->attach_rwsem );
+	return 0;
+}
+
+static int wait_satisfied( struct wait_info *winfo, int wait_mask, int *status,
+	gpib_descriptor_t *desc )
+{
+	gpib_board_t *board = winfo->board;
+	int temp_status;
+	int retval;
+
+	retval = locked_ibstatus( board, desc, 0, 0, desc, &temp_status );
+	if( retval < 0 )
+		return retval;
 
 	if( winfo->timed_out )
 		temp_status |= TIMO;
@@ -63,13 +97,14 @@ static int wait_satisfied( struct wait_info *winfo, gpib_status_queue_t *status_
 	return 0;
 }
 
-static void wait_timeout( unsigned long arg )
+static enum hrtimer_restart wait_timeout( struct hrtimer *timer )
 /* Watchdog timeout routine */
 {
-	struct wait_info *winfo = ( struct wait_info * ) arg;
+	struct wait_info *winfo = container_of( timer, struct wait_info, timer );
 
 	winfo->timed_out = 1;
-	wake_up_interruptible( &winfo->board->wait );
+	wake_up_interruptible( winfo->wait );
+	return HRTIMER_NORESTART;
 }
 
 /* install timer interrupt handler */
@@ -79,18 +114,54 @@ static void startWaitTimer( struct wait_info *winfo )
 	winfo->timed_out = 0;
 
 	if( winfo->usec_timeout > 0 )
-	{
-		winfo->timer.expires = jiffies + usec_to_jiffies( winfo->usec_timeout );
-		winfo->timer.function = wait_timeout;
-		winfo->timer.data = (unsigned long) winfo;
-		add_timer( &winfo->timer );              /* add timer           */
-	}
+		hrtimer_start( &winfo->timer, ktime_set( winfo->usec_timeout / 1000000,
+			( winfo->usec_timeout % 1000000 ) * 1000 ), HRTIMER_MODE_REL );
 }
 
 static void removeWaitTimer( struct wait_info *winfo )
 {
-	if( timer_pending( &winfo->timer ) )
-		del_timer_sync( &winfo->timer );
+	hrtimer_cancel( &winfo->timer );
+	destroy_hrtimer_on_stack( &winfo->timer );
+}
+
+/* Sleeps until wait_satisfied(), only on the queues that can be woken by a
+ * change of the bits in wait_mask: the descriptor's own queue always (for
+ * CMPL and our timer), board->rqs_wait for RQS on a device, and board->wait
+ * only if a bit set by the driver (END included) is wanted. */
+static int wait_for_status( struct wait_info *winfo, int wait_mask, int *status,
+	gpib_descriptor_t *desc )
+{
+	gpib_board_t *board = winfo->board;
+	DEFINE_WAIT( desc_entry );
+	DEFINE_WAIT( rqs_entry );
+	DEFINE_WAIT( board_entry );
+	int want_rqs = ( wait_mask & RQS ) && desc->is_board == 0;
+	int want_board = wait_mask & ~GPIB_DESCRIPTOR_STATUS_MASK;
+	int retval;
+
+	for( ;; )
+	{
+		prepare_to_wait( desc->wait, &desc_entry, TASK_INTERRUPTIBLE );
+		if( want_rqs )
+			prepare_to_wait( &board->rqs_wait, &rqs_entry, TASK_INTERRUPTIBLE );
+		if( want_board )
+			prepare_to_wait( &board->wait, &board_entry, TASK_INTERRUPTIBLE );
+		retval = wait_satisfied( winfo, wait_mask, status, desc );
+		if( retval ) break;
+		if( signal_pending( current ) )
+		{
+			retval = -ERESTARTSYS;
+			break;
+		}
+		schedule();
+	}
+	finish_wait( desc->wait, &desc_entry );
+	if( want_rqs )
+		finish_wait( &board->rqs_wait, &rqs_entry );
+	if( want_board )
+		finish_wait( &board->wait, &board_entry );
+
+	return retval < 0 ? retval : 0;
 }
 
 /*
@@ -100,47 +171,35 @@ static void removeWaitTimer( struct wait_info *winfo )
  * has a bit set for each condition which can terminate the wait
  * If the mask is 0 then
  * no condition is waited for.
+ * Called without board->big_gpib_mutex, so a wait isn't held up by a
+ * serial poll or other operation holding it between status checks.
  */
 int ibwait( gpib_board_t *board, int wait_mask, int clear_mask, int set_mask,
 	int *status, unsigned long usec_timeout, gpib_descriptor_t *desc )
 {
 	int retval = 0;
-	gpib_status_queue_t *status_queue;
+	int temp_status;
 	struct wait_info winfo;
 
-	if( desc->is_board ) status_queue = NULL;
-	else status_queue = get_gpib_status_queue( board, desc->pad, desc->sad );
-
 	if( wait_mask == 0 )
-	{
-		*status = general_ibstatus( board, status_queue, clear_mask, set_mask, desc );
-		return 0;
-	}
-
-	mutex_unlock( &board->big_gpib_mutex );
+		return locked_ibstatus( board, desc, clear_mask, set_mask, desc, status );
 
 	init_wait_info( &winfo );
 	winfo.board = board;
+	winfo.wait = desc->wait;
 	winfo.usec_timeout = usec_timeout;
 	startWaitTimer( &winfo );
 
-	if( wait_event_interruptible( board->wait,
-		wait_satisfied( &winfo, status_queue, wait_mask, status, desc ) ) )
-	{
+	retval = wait_for_status( &winfo, wait_mask, status, desc );
+	if( retval )
 		printk( "wait interrupted\n" );
-		retval = -ERESTARTSYS;
-	}
 	removeWaitTimer( &winfo );
 
 	if(retval) return retval;
-	if(mutex_lock_interruptible( &board->big_gpib_mutex ))
-	{
-		return -ERESTARTSYS;
-	}
 
 	/* make sure we only clear status bits that we are reporting */
 	if( *status & clear_mask || set_mask )
-		general_ibstatus( board, status_queue, *status & clear_mask, set_mask, 0 );
+		return locked_ibstatus( board, desc, *status & clear_mask, set_mask, NULL, &temp_status );
 
 	return 0;
 }
@@ -21,7 +21,24 @@
 #include <linux/fcntl.h>
 #include <linux/kmod.h>
 #include <linux/vmalloc.h>
+#include <linux/highmem.h>
 #include <linux/version.h>
+#include <linux/mm.h>
+#include <linux/poll.h>
+#include <linux/workqueue.h>
+#include <linux/completion.h>
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4,11,0)
+#include <linux/sched/mm.h>
+#else
+#define mmget( mm ) atomic_inc( &( mm )->mm_users )
+#endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5,8,0)
+#include <linux/kthread.h>
+#else
+#include <linux/mmu_context.h>
+#define kthread_use_mm use_mm
+#define kthread_unuse_mm unuse_mm
+#endif
 
 static int board_type_ioctl(gpib_file_private_t *file_priv, gpib_board_t *board, unsigned long arg);
 static int read_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
@@ -33,6 +50,7 @@ static int command_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
 static int open_dev_ioctl( struct file *filep, gpib_board_t *board, unsigned long arg );
 static int close_dev_ioctl( struct file *filep, gpib_board_t *board, unsigned long arg );
 static int serial_poll_ioctl( gpib_board_t *board, unsigned long arg );
+static int serial_poll_list_ioctl( gpib_board_t *board, unsigned long arg );
 static int wait_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board, unsigned long arg );
 static int parallel_poll_ioctl( gpib_board_t *board, unsigned long arg );
 static int online_ioctl( gpib_board_t *board, unsigned long arg );
@@ -61,6 +79,18 @@ static int select_pci_ioctl( gpib_board_t *board, unsigned long arg );
 static int event_ioctl( gpib_board_t *board, unsigned long arg );
 static int request_system_control_ioctl( gpib_board_t *board, unsigned long arg );
 static int t1_delay_ioctl( gpib_board_t *board, unsigned long arg );
+static int xfer_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
+	unsigned long arg );
+static int buffer_size_ioctl( gpib_board_t *board, unsigned long arg );
+static int pseudo_irq_ioctl( gpib_board_t *board, unsigned long arg );
+static int pio_poll_ioctl( gpib_board_t *board, unsigned long arg );
+static int poll_mask_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
+	unsigned long arg );
+static int aio_start_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
+	unsigned long arg );
+static int aio_complete_ioctl( gpib_file_private_t *file_priv, unsigned long arg );
+static int aio_cancel_ioctl( gpib_file_private_t *file_priv, unsigned long arg );
+static void cleanup_aio( gpib_descriptor_t *desc );
 
 static int cleanup_open_devices( gpib_file_private_t *file_priv, gpib_board_t *board );
 
@@ -85,8 +115,10 @@ static int init_gpib_file_private( gpib_file_private_t *priv )
 		printk( "gpib: failed to allocate default board descriptor\n" );
 		return -ENOMEM;
 	}
+	init_waitqueue_head( &priv->wait );
 	init_gpib_descriptor( priv->descriptors[ 0 ] );
 	priv->descriptors[ 0 ]->is_board = 1;
+	priv->descriptors[ 0 ]->wait = &priv->wait;
 	mutex_init(&priv->descriptors_mutex);
 	return 0;
 }
@@ -159,9 +191,11 @@ int ibclose(struct inode *inode, struct file *filep)
 
 	if( priv )
 	{
-		cleanup_open_devices( priv, board );
+		/* background transfers may be waiting for the lock, so release
+		 * it before cleanup_open_devices() waits for them */
 		if( atomic_read(&priv->holding_mutex) )
 			mutex_unlock( &board->user_mutex );
+		cleanup_open_devices( priv, board );
 
 		if(priv->got_module && board->use_count)
 		{
@@ -177,6 +211,113 @@ int ibclose(struct inode *inode, struct file *filep)
 
 
 
+/* maps the board's state page read-only into user space */
+int ibmmap( struct file *filep, struct vm_area_struct *vma )
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3,19,0)
+	unsigned int minor = iminor(filep->f_dentry->d_inode);
+#else
+	unsigned int minor = iminor(filep->f_path.dentry->d_inode);
+#endif
+	gpib_board_t *board;
+
+	if( minor >= GPIB_MAX_NUM_BOARDS )
+	{
+		printk("gpib: invalid minor number of device file\n");
+		return -ENODEV;
+	}
+	board = &board_array[ minor ];
+
+	if( board->state_page == NULL ) return -ENODEV;
+	if( vma->vm_pgoff != 0 || vma->vm_end - vma->vm_start > PAGE_SIZE )
+		return -EINVAL;
+	if( vma->vm_flags & VM_WRITE )
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return remap_pfn_range( vma, vma->vm_start,
+		virt_to_phys( board->state_page ) >> PAGE_SHIFT,
+		vma->vm_end - vma->vm_start, vma->vm_page_prot );
+}
+
+/* The device file polls readable (and POLLPRI) when the status of any of its
+ * descriptors matches that descriptor's poll mask.  It sleeps on every wait
+ * queue IBWAIT might use, whatever the masks are now, since epoll only
+ * registers the queues once and the masks can change later.  So anything
+ * that would end an IBWAIT wakes it. */
+unsigned int ibpoll( struct file *filep, struct poll_table_struct *wait )
+{
+#if LINUX_VERSION_CODE < KERNEL_VERSION(3,19,0)
+	unsigned int minor = iminor(filep->f_dentry->d_inode);
+#else
+	unsigned int minor = iminor(filep->f_path.dentry->d_inode);
+#endif
+	gpib_board_t *board;
+	gpib_file_private_t *file_priv = filep->private_data;
+	unsigned int mask = 0;
+	int i;
+
+	if( minor >= GPIB_MAX_NUM_BOARDS )
+	{
+		printk("gpib: invalid minor number of device file\n");
+		return POLLERR;
+	}
+	board = &board_array[ minor ];
+
+	/* woken by io completion and IBPOLL_MASK on any of our descriptors */
+	poll_wait( filep, &file_priv->wait, wait );
+	poll_wait( filep, &board->rqs_wait, wait );
+	poll_wait( filep, &board->wait, wait );
+
+	mutex_lock( &board->big_gpib_mutex );
+	for( i = 0; i < GPIB_MAX_NUM_DESCRIPTORS; i++ )
+	{
+		gpib_descriptor_t *desc = file_priv->descriptors[ i ];
+		gpib_status_queue_t *status_queue;
+
+		if( desc == NULL || desc->poll_mask == 0 ) continue;
+
+		if( desc->is_board ) status_queue = NULL;
+		else status_queue = get_gpib_status_queue( board, desc->pad, desc->sad );
+		if( general_ibstatus( board, status_queue, 0, 0, desc ) & desc->poll_mask )
+		{
+			mask = POLLIN | POLLRDNORM | POLLPRI;
+			break;
+		}
+	}
+	mutex_unlock( &board->big_gpib_mutex );
+
+	return mask;
+}
+
+/* Handles the ioctls which only look at state with its own locking (the
+ * board info snapshot, the event and status byte queues) or which sleep.
+ * Anything calling into the driver stays under big_gpib_mutex, since
+ * iboffline() detaches the driver before it clears board->online.  Returns
+ * -ENOIOCTLCMD for anything else, or if the board is in a state the locked
+ * path reports errors for. */
+static long unlocked_query_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
+	unsigned int cmd, unsigned long arg )
+{
+	if( cmd == IBBOARD_INFO )
+		return board_info_ioctl( board, arg );
+	if( !board->online )
+		return -ENOIOCTLCMD;
+	switch( cmd )
+	{
+		case IBEVENT:
+			return event_ioctl( board, arg );
+		case IBSPOLL_BYTES:
+			return status_bytes_ioctl( board, arg );
+		case IBWAIT:
+			/* ibwait() takes big_gpib_mutex itself for each status check */
+			return wait_ioctl( file_priv, board, arg );
+		default:
+			break;
+	}
+	return -ENOIOCTLCMD;
+}
+
 long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 {
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3,19,0)
@@ -195,6 +336,15 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 	}
 	board = &board_array[ minor ];
 
+	/* Once this file holds a reference on the driver, queries don't need
+	 * board->big_gpib_mutex and so aren't held up behind a serial poll or
+	 * other long operation. */
+	if( file_priv->got_module )
+	{
+		retval = unlocked_query_ioctl( file_priv, board, cmd, arg );
+		if( retval != -ENOIOCTLCMD ) return retval;
+	}
+
 	if(mutex_lock_interruptible(&board->big_gpib_mutex))
 	{
 		return -ERESTARTSYS;
@@ -276,6 +426,19 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 			retval = select_pci_ioctl( board, arg );
 			goto done;
 			break;
+		case IBPSEUDO_IRQ:
+			retval = pseudo_irq_ioctl( board, arg );
+			goto done;
+			break;
+		case IBPIO_POLL:
+			retval = pio_poll_ioctl( board, arg );
+			goto done;
+			break;
+		case IBBUFFER_SIZE:
+			/* board->buffer_rwsem has to be locked before board->big_gpib_mutex */
+			mutex_unlock(&board->big_gpib_mutex);
+			return buffer_size_ioctl( board, arg );
+			break;
 		default:
 			break;
 	}
@@ -307,9 +470,9 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 			goto done;
 			break;
 		case IBWAIT:
-			retval = wait_ioctl( file_priv, board, arg );
-			if(retval == -ERESTARTSYS) return retval;
-			goto done;
+			/* may sleep, ibwait() takes board->attach_rwsem for each status check */
+			mutex_unlock(&board->big_gpib_mutex);
+			return wait_ioctl( file_priv, board, arg );
 			break;
 		case IBLINES:
 			retval = line_status_ioctl( board, arg );
@@ -320,6 +483,30 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 			retval = 0;
 			goto done;
 			break;
+		case IBXFER:
+			/* IBXFER takes board->user_mutex itself, so we need to unlock
+			 * board->big_gpib_mutex first to maintain consistent locking order */
+			mutex_unlock(&board->big_gpib_mutex);
+			return xfer_ioctl( file_priv, board, arg );
+			break;
+		case IBAIO_START:
+			retval = aio_start_ioctl( file_priv, board, arg );
+			goto done;
+			break;
+		case IBAIO_COMPLETE:
+			/* waits for the worker, which needs board->big_gpib_mutex */
+			mutex_unlock(&board->big_gpib_mutex);
+			return aio_complete_ioctl( file_priv, arg );
+			break;
+		case IBAIO_CANCEL:
+			retval = aio_cancel_ioctl( file_priv, arg );
+			goto done;
+			break;
+		case IBPOLL_MASK:
+			/* ibpollfd() doesn't take the board lock */
+			retval = poll_mask_ioctl( file_priv, board, arg );
+			goto done;
+			break;
 		default:
 			break;
 	}
@@ -385,6 +572,10 @@ long ibioctl(struct file *filep, unsigned int cmd, unsigned long arg)
 			retval = serial_poll_ioctl( board, arg );
 			goto done;
 			break;
+		case IBRSP_LIST:
+			retval = serial_poll_list_ioctl( board, arg );
+			goto done;
+			break;
 		case IBRSV:
 			retval = request_service_ioctl( board, arg );
 			goto done;
@@ -475,6 +666,7 @@ static int board_type_ioctl(gpib_file_private_t *file_priv, gpib_board_t *board,
 				++board->use_count;
 			}
 			file_priv->got_module = 1;
+			board_info_changed( board );
 			return 0;
 		}
 	}
@@ -482,6 +674,243 @@ static int board_type_ioctl(gpib_file_private_t *file_priv, gpib_board_t *board,
 	return -EINVAL;
 }
 
+/* largest chunk of a user buffer we pin and map at once for direct io */
+static const unsigned long max_direct_io_length = 0x100000;
+
+/* Pins the user pages under userbuf and maps them into contiguous kernel
+ * virtual memory.  Returns the kernel address corresponding to userbuf,
+ * or NULL on failure. */
+static uint8_t* map_user_buffer( uint8_t *userbuf, unsigned long length, int writing_to_user,
+	struct page ***pages, int *num_pages )
+{
+	unsigned long start = ( unsigned long ) userbuf & PAGE_MASK;
+	unsigned long offset = ( unsigned long ) userbuf & ~PAGE_MASK;
+	int count = ( offset + length + PAGE_SIZE - 1 ) >> PAGE_SHIFT;
+	int pinned;
+	void *kernel_address;
+	int i;
+
+	*pages = kmalloc( count * sizeof( struct page * ), GFP_KERNEL );
+	if( *pages == NULL ) return NULL;
+	/* the third argument became gup_flags in newer kernels, where FOLL_WRITE == 1 */
+	pinned = get_user_pages_fast( start, count, writing_to_user, *pages );
+	if( pinned < count )
+	{
+		for( i = 0; i < pinned; i++ )
+			put_page( ( *pages )[ i ] );
+		kfree( *pages );
+		return NULL;
+	}
+	kernel_address = vmap( *pages, count, VM_MAP, PAGE_KERNEL );
+	if( kernel_address == NULL )
+	{
+		for( i = 0; i < count; i++ )
+			put_page( ( *pages )[ i ] );
+		kfree( *pages );
+		return NULL;
+	}
+	*num_pages = count;
+	return ( uint8_t * ) kernel_address + offset;
+}
+
+static void unmap_user_buffer( uint8_t *kernel_address, struct page **pages, int num_pages,
+	int writing_to_user )
+{
+	void *start = ( void * ) ( ( unsigned long ) kernel_address & PAGE_MASK );
+	int i;
+
+	/* data written through our alias must reach the user's mapping on cpus
+	 * with aliasing caches */
+	if( writing_to_user )
+		flush_kernel_vmap_range( start, num_pages * PAGE_SIZE );
+	vunmap( start );
+	for( i = 0; i < num_pages; i++ )
+	{
+		if( writing_to_user )
+			set_page_dirty_lock( pages[ i ] );
+		put_page( pages[ i ] );
+	}
+	kfree( pages );
+}
+
+/* Length of the next ibrd()/ibwrt() call for a transfer with remain bytes
+ * left, given chunks of at most max_chunk.  Never more than the driver can
+ * do in one call, so it doesn't have to split (and complain) itself. */
+static unsigned long transfer_chunk_length( const gpib_board_t *board, unsigned long max_chunk,
+	unsigned long remain )
+{
+	unsigned long limit = board->interface->caps.max_transfer_length;
+
+	if( limit && limit < max_chunk )
+		max_chunk = limit;
+	return ( max_chunk < remain ) ? max_chunk : remain;
+}
+
+/* Can we skip bouncing this transfer through board->buffer?  Only worth the
+ * cost of pinning pages if the transfer wouldn't fit in one chunk anyway. */
+static int use_direct_io( const gpib_board_t *board, unsigned long length )
+{
+	return board->interface->direct_io && length > board->buffer_length;
+}
+
+/* The direct io transfers return 1 if they couldn't pin or map part of the
+ * user buffer, which happens for VM_IO or PFNMAP mappings that copy_to_user()
+ * and copy_from_user() handle fine.  The rest of the transfer is left in
+ * *remain for the caller to bounce through board->buffer. */
+static int direct_read_to_user( gpib_board_t *board, uint8_t *userbuf, unsigned long *remain,
+	int *end_flag )
+{
+	ssize_t read_ret = 0;
+	size_t nbytes;
+	struct page **pages;
+	int num_pages;
+	uint8_t *buffer;
+	unsigned long length;
+
+	*end_flag = 0;
+	while(*remain > 0 && *end_flag == 0)
+	{
+		length = transfer_chunk_length( board, max_direct_io_length, *remain );
+		buffer = map_user_buffer( userbuf, length, 1, &pages, &num_pages );
+		if( buffer == NULL ) return 1;
+		nbytes = 0;
+		read_ret = ibrd(board, buffer, length, end_flag, &nbytes);
+		unmap_user_buffer( buffer, pages, num_pages, 1 );
+		if(nbytes == 0) break;
+		*remain -= nbytes;
+		userbuf += nbytes;
+		if(read_ret < 0) break;
+	}
+	if(*remain == 0 || *end_flag)
+	{
+		read_ret = 0;
+	}
+	return read_ret;
+}
+
+static int direct_write_from_user( gpib_board_t *board, uint8_t *userbuf, unsigned long *remain,
+	int send_eoi )
+{
+	int retval = 0;
+	struct page **pages;
+	int num_pages;
+	uint8_t *buffer;
+	unsigned long length;
+
+	while(*remain > 0)
+	{
+		size_t bytes_written = 0;
+
+		length = transfer_chunk_length( board, max_direct_io_length, *remain );
+		buffer = map_user_buffer( userbuf, length, 0, &pages, &num_pages );
+		if( buffer == NULL ) return 1;
+		retval = ibwrt(board, buffer, length, length == *remain && send_eoi,
+			&bytes_written);
+		unmap_user_buffer( buffer, pages, num_pages, 0 );
+		*remain -= bytes_written;
+		userbuf += bytes_written;
+		if(retval < 0)
+		{
+			break;
+		}
+	}
+	if(*remain == 0)
+	{
+		retval = 0;
+	}
+	return retval;
+}
+
+/* number of consecutive transfers too large for board->buffer before we grow it */
+static const unsigned int large_transfer_threshold = 4;
+
+/* Grows board->buffer, up to board->max_buffer_length, if transfers keep
+ * having to be split into several ibrd()/ibwrt() calls. */
+static void adapt_buffer_length( gpib_board_t *board, unsigned long length )
+{
+	unsigned int new_length;
+	unsigned int max_length = board->max_buffer_length;
+
+	if( length <= board->buffer_length )
+	{
+		board->large_transfer_count = 0;
+		return;
+	}
+	/* a buffer larger than the driver can use in one call doesn't help */
+	if( board->interface->caps.max_transfer_length &&
+		board->interface->caps.max_transfer_length < max_length )
+		max_length = board->interface->caps.max_transfer_length;
+	if( board->buffer_length == 0 || board->buffer_length >= max_length )
+		return;
+	if( ++board->large_transfer_count < large_transfer_threshold )
+		return;
+	/* don't wait for io on other descriptors to finish, just try again later */
+	if( down_write_trylock( &board->buffer_rwsem ) == 0 )
+		return;
+	mutex_lock( &board->big_gpib_mutex );
+	new_length = board->buffer_length;
+	while( new_length < length && new_length < max_length )
+		new_length *= 2;
+	if( new_length > max_length )
+		new_length = max_length;
+	if( gpib_resize_buffer( board, new_length ) == 0 )
+	{
+		GPIB_DPRINTK( "gpib: grew transfer buffer to %u bytes\n", board->buffer_length );
+		board_info_changed( board );
+	}
+	mutex_unlock( &board->big_gpib_mutex );
+	up_write( &board->buffer_rwsem );
+}
+
+/* Read buffer loads till we fill the user supplied buffer or get an END.
+ * On return, *remain holds the number of bytes which were not transferred. */
+static int read_to_user( gpib_board_t *board, uint8_t *userbuf, unsigned long *remain,
+	int *end_flag )
+{
+	ssize_t read_ret = 0;
+	size_t nbytes;
+
+	if( use_direct_io( board, *remain ) )
+	{
+		unsigned long length = *remain;
+
+		read_ret = direct_read_to_user( board, userbuf, remain, end_flag );
+		if( read_ret <= 0 )
+			return read_ret;
+		userbuf += length - *remain;
+	}
+
+	adapt_buffer_length( board, *remain );
+	down_read( &board->buffer_rwsem );
+	*end_flag = 0;
+	while(*remain > 0 && *end_flag == 0)
+	{
+		nbytes = 0;
+		read_ret = ibrd(board, board->buffer, transfer_chunk_length( board, board->buffer_length, *remain ),
+			end_flag, &nbytes);
+		if(nbytes == 0) break;
+		if(copy_to_user(userbuf, board->buffer, nbytes))
+		{
+			up_read( &board->buffer_rwsem );
+			return -EFAULT;
+		}
+		*remain -= nbytes;
+		userbuf += nbytes;
+		if(read_ret < 0) break;
+	}
+	up_read( &board->buffer_rwsem );
+	/* suppress errors (for example due to timeout or interruption by device clear)
+	if all bytes got sent.  This prevents races that can occur in the various drivers
+	if a device receives a device clear immediately after a transfer completes and
+	the driver code wasn't careful enough to handle that case.
+	*/
+	if(*remain == 0 || *end_flag)
+	{
+		read_ret = 0;
+	}
+	return read_ret;
+}
+
 static int read_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
 	unsigned long arg)
 {
@@ -492,7 +921,6 @@ static int read_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
 	int retval;
 	ssize_t read_ret = 0;
 	gpib_descriptor_t *desc;
-	size_t nbytes;
 
 	retval = copy_from_user(&read_cmd, (void*) arg, sizeof(read_cmd));
 	if (retval)
@@ -508,191 +936,611 @@ static int read_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
 	userbuf = (uint8_t*)(unsigned long)read_cmd.buffer_ptr;
 	userbuf += read_cmd.completed_transfer_count;
 
-	remain = read_cmd.requested_transfer_count - read_cmd.completed_transfer_count;
+	remain = read_cmd.requested_transfer_count - read_cmd.completed_transfer_count;
+
+	/* Check write access to buffer */
+	if(!access_ok(VERIFY_WRITE, userbuf, remain))
+		return -EFAULT;
+
+	atomic_set(&desc->io_in_progress, 1);
+
+	osSetDeadline(board, board->usec_timeout);
+	read_ret = read_to_user(board, userbuf, &remain, &end_flag);
+	osClearDeadline(board);
+	if(read_ret == -EFAULT)
+		retval = -EFAULT;
+	read_cmd.completed_transfer_count = read_cmd.requested_transfer_count - remain;
+	read_cmd.end = end_flag;
+	if(retval == 0)
+		retval = copy_to_user((void*) arg, &read_cmd, sizeof(read_cmd));
+	atomic_set(&desc->io_in_progress, 0);
+	wake_up_interruptible( desc->wait );
+	if(retval) return -EFAULT;
+
+	return read_ret;
+}
+
+/* Write buffer loads till we empty the user supplied buffer.
+	Call drivers at least once, even if remain is zero, in
+	order to allow them to insure previous commands were
+	completely finished, in the case of a restarted ioctl.  */
+static int command_from_user( gpib_board_t *board, uint8_t *userbuf, unsigned long *remain )
+{
+	int retval;
+	size_t bytes_written;
+
+	down_read( &board->buffer_rwsem );
+	do
+	{
+		if(copy_from_user(board->buffer, userbuf, (board->buffer_length < *remain) ?
+			board->buffer_length : *remain ))
+		{
+			retval = -EFAULT;
+			break;
+		}
+		bytes_written = 0;
+		retval = ibcmd(board, board->buffer, (board->buffer_length < *remain) ?
+			board->buffer_length : *remain, &bytes_written );
+		*remain -= bytes_written;
+		userbuf += bytes_written;
+		if(retval < 0)
+			break;
+	}while( *remain > 0 );
+	up_read( &board->buffer_rwsem );
+
+	return retval;
+}
+
+static int command_ioctl( gpib_file_private_t *file_priv,
+	gpib_board_t *board, unsigned long arg)
+{
+	read_write_ioctl_t cmd;
+	uint8_t *userbuf;
+	unsigned long remain;
+	int retval;
+	int fault = 0;
+	gpib_descriptor_t *desc;
+
+	retval = copy_from_user(&cmd, (void*) arg, sizeof(cmd));
+	if( retval )
+		return -EFAULT;
+
+	if(cmd.completed_transfer_count > cmd.requested_transfer_count)
+		return -EINVAL;
+
+	desc = handle_to_descriptor( file_priv, cmd.handle );
+	if( desc == NULL ) return -EINVAL;
+
+	userbuf = (uint8_t*)(unsigned long)cmd.buffer_ptr;
+	userbuf += cmd.completed_transfer_count;
+
+	remain = cmd.requested_transfer_count - cmd.completed_transfer_count;
+
+	/* Check read access to buffer */
+	if(!access_ok(VERIFY_READ, userbuf, remain))
+		return -EFAULT;
+
+	atomic_set(&desc->io_in_progress, 1);
+	osSetDeadline(board, board->usec_timeout);
+	retval = command_from_user( board, userbuf, &remain );
+	osClearDeadline(board);
+	
+	cmd.completed_transfer_count = cmd.requested_transfer_count - remain;
+
+	if(retval == -EFAULT)
+		fault = 1;
+	else
+		fault = copy_to_user((void*) arg, &cmd, sizeof(cmd));
+	atomic_set(&desc->io_in_progress, 0);
+	wake_up_interruptible( desc->wait );
+	if( fault ) return -EFAULT;
+
+	return retval;
+}
+
+/* Write buffer loads till we empty the user supplied buffer.  EOI is asserted
+ * with the last byte if send_eoi is nonzero.  On return, *remain holds
+ * the number of bytes which were not transferred. */
+static int write_from_user( gpib_board_t *board, uint8_t *userbuf, unsigned long *remain,
+	int send_eoi )
+{
+	int retval = 0;
+
+	if( use_direct_io( board, *remain ) )
+	{
+		unsigned long length = *remain;
+
+		retval = direct_write_from_user( board, userbuf, remain, send_eoi );
+		if( retval <= 0 )
+			return retval;
+		userbuf += length - *remain;
+	}
+
+	adapt_buffer_length( board, *remain );
+	down_read( &board->buffer_rwsem );
+	while(*remain > 0)
+	{
+		size_t bytes_written = 0;
+		unsigned long length = transfer_chunk_length( board, board->buffer_length, *remain );
+
+		if(copy_from_user(board->buffer, userbuf, length))
+		{
+			up_read( &board->buffer_rwsem );
+			return -EFAULT;
+		}
+		retval = ibwrt(board, board->buffer, length, length == *remain && send_eoi,
+			&bytes_written);
+		*remain -= bytes_written;
+		userbuf += bytes_written;
+		if(retval < 0)
+		{
+			break;
+		}
+	}
+	up_read( &board->buffer_rwsem );
+	/* suppress errors (for example due to timeout or interruption by device clear)
+	if all bytes got sent.  This prevents races that can occur in the various drivers
+	if a device receives a device clear immediately after a transfer completes and
+	the driver code wasn't careful enough to handle that case.
+	*/
+	if(*remain == 0)
+	{
+		retval = 0;
+	}
+	return retval;
+}
+
+static int write_ioctl(gpib_file_private_t *file_priv, gpib_board_t *board,
+	unsigned long arg)
+{
+	read_write_ioctl_t write_cmd;
+	uint8_t *userbuf;
+	unsigned long remain;
+	int retval = 0;
+	int fault;
+	gpib_descriptor_t *desc;
+
+	fault = copy_from_user(&write_cmd, (void*) arg, sizeof(write_cmd));
+	if(fault)
+		return -EFAULT;
+
+	if(write_cmd.completed_transfer_count > write_cmd.requested_transfer_count)
+		return -EINVAL;
+
+	desc = handle_to_descriptor( file_priv, write_cmd.handle );
+	if( desc == NULL ) return -EINVAL;
+
+	userbuf = (uint8_t*)(unsigned long)write_cmd.buffer_ptr;
+	userbuf += write_cmd.completed_transfer_count;
+	
+	remain = write_cmd.requested_transfer_count - write_cmd.completed_transfer_count;
+
+	/* Check read access to buffer */
+	if(!access_ok(VERIFY_READ, userbuf, remain))
+		return -EFAULT;
+
+	atomic_set(&desc->io_in_progress, 1);
+
+	osSetDeadline(board, board->usec_timeout);
+	retval = write_from_user(board, userbuf, &remain, write_cmd.end);
+	osClearDeadline(board);
+	if(retval == -EFAULT)
+		fault = 1;
+	write_cmd.completed_transfer_count = write_cmd.requested_transfer_count - remain;
+	if(fault == 0)
+		fault = copy_to_user((void*) arg, &write_cmd, sizeof(write_cmd));
+	atomic_set(&desc->io_in_progress, 0);
+	wake_up_interruptible( desc->wait );
+	if(fault) return -EFAULT;
+
+	return retval;
+}
+
+/* Sends the command bytes which address the board and the device at pad/sad for
+ * a transfer.  For reads the device is made talker, for writes it is made listener. */
+static int xfer_address( gpib_board_t *board, unsigned int pad, int sad, int write )
+{
+	uint8_t cmd_string[8];
+	size_t bytes_written;
+	int i = 0;
+	int retval;
+
+	if( write )
+	{
+		cmd_string[ i++ ] = MTA( board->pad );
+		if( board->sad >= 0 )
+			cmd_string[ i++ ] = MSA( board->sad );
+		cmd_string[ i++ ] = UNL;
+		cmd_string[ i++ ] = MLA( pad );
+		if( sad >= 0 )
+			cmd_string[ i++ ] = MSA( sad );
+	}else
+	{
+		cmd_string[ i++ ] = UNL;
+		cmd_string[ i++ ] = MLA( board->pad );
+		if( board->sad >= 0 )
+			cmd_string[ i++ ] = MSA( board->sad );
+		cmd_string[ i++ ] = MTA( pad );
+		if( sad >= 0 )
+			cmd_string[ i++ ] = MSA( sad );
+	}
+
+	retval = ibcmd( board, cmd_string, i, &bytes_written );
+	if( retval < 0 ) return retval;
+	if( bytes_written < i ) return -EIO;
+
+	return 0;
+}
+
+/* a transfer started by IBAIO_START, done by a kernel worker */
+struct gpib_aio
+{
+	struct work_struct work;
+	gpib_board_t *board;
+	gpib_descriptor_t *desc;
+	/* address space of the process which owns the buffer */
+	struct mm_struct *mm;
+	xfer_ioctl_t cmd;
+	int retval;
+	struct completion done;
+	/* protects cancelled and transferring */
+	spinlock_t lock;
+	unsigned cancelled : 1;
+	unsigned transferring : 1;
+};
+
+/* Marks the start of the part of a background transfer which may be aborted
+ * by osAbortIo().  Fails if the transfer was already cancelled. */
+static int aio_begin_io( struct gpib_aio *aio )
+{
+	int retval = 0;
+
+	spin_lock( &aio->lock );
+	if( aio->cancelled )
+		retval = -ECANCELED;
+	else
+		aio->transferring = 1;
+	spin_unlock( &aio->lock );
+
+	return retval;
+}
+
+static void aio_end_io( struct gpib_aio *aio )
+{
+	spin_lock( &aio->lock );
+	aio->transferring = 0;
+	spin_unlock( &aio->lock );
+}
+
+static void aio_cancel( struct gpib_aio *aio )
+{
+	spin_lock( &aio->lock );
+	aio->cancelled = 1;
+	/* only abort the board's io if it is ours */
+	if( aio->transferring )
+		osAbortIo( aio->board );
+	spin_unlock( &aio->lock );
+}
+
+/* Checks the arguments of an IBXFER or IBAIO_START ioctl. */
+static int check_xfer_cmd( const gpib_file_private_t *file_priv, const xfer_ioctl_t *cmd,
+	gpib_descriptor_t **desc )
+{
+	uint8_t *userbuf;
+	unsigned long remain;
+
+	if( cmd->completed_transfer_count > cmd->requested_transfer_count )
+		return -EINVAL;
+	if( cmd->address_target && ( cmd->pad > gpib_addr_max || cmd->sad > gpib_addr_max ) )
+		return -EINVAL;
+	if( cmd->command && cmd->address_target )
+		return -EINVAL;
+
+	*desc = handle_to_descriptor( file_priv, cmd->handle );
+	if( *desc == NULL ) return -EINVAL;
+
+	userbuf = (uint8_t*)(unsigned long)cmd->buffer_ptr;
+	userbuf += cmd->completed_transfer_count;
+	remain = cmd->requested_transfer_count - cmd->completed_transfer_count;
+
+	if(!access_ok(cmd->write || cmd->command ? VERIFY_READ : VERIFY_WRITE, userbuf, remain))
+		return -EFAULT;
+
+	return 0;
+}
+
+/* Does the transfer for an IBXFER or IBAIO_START ioctl, updating cmd with
+ * the results.  The caller must hold board->user_mutex.  aio is NULL
+ * unless this is a background transfer. */
+static int do_xfer( gpib_board_t *board, gpib_descriptor_t *desc, xfer_ioctl_t *cmd,
+	struct gpib_aio *aio )
+{
+	uint8_t *userbuf;
+	unsigned long remain;
+	gpib_status_queue_t *status_queue;
+	int end_flag = 0;
+	int retval;
+
+	userbuf = (uint8_t*)(unsigned long)cmd->buffer_ptr;
+	userbuf += cmd->completed_transfer_count;
+	remain = cmd->requested_transfer_count - cmd->completed_transfer_count;
+
+	if( mutex_lock_interruptible( &board->big_gpib_mutex ) )
+		return -ERESTARTSYS;
+	board->usec_timeout = cmd->usec_timeout;
+	board_timeout_changed( board );
+	if( cmd->write || cmd->command )
+		retval = 0;
+	else
+		retval = ibeos( board, cmd->eos, cmd->eos_flags );
+	/* IO can take a long time, so it is done without holding board->big_gpib_mutex,
+	 * just as for the IBCMD, IBRD and IBWRT ioctls */
+	mutex_unlock( &board->big_gpib_mutex );
+
+	atomic_set(&desc->io_in_progress, 1);
+	/* the timeout covers the addressing as well as the whole transfer */
+	osSetDeadline( board, cmd->usec_timeout );
+	if( retval == 0 && aio )
+		retval = aio_begin_io( aio );
+	if( retval == 0 && cmd->address_target )
+		retval = xfer_address( board, cmd->pad, cmd->sad, cmd->write );
+	if( retval == 0 )
+	{
+		if( cmd->command )
+			retval = command_from_user( board, userbuf, &remain );
+		else if( cmd->write )
+			retval = write_from_user( board, userbuf, &remain, cmd->end );
+		else
+			retval = read_to_user( board, userbuf, &remain, &end_flag );
+	}
+	if( aio )
+		aio_end_io( aio );
+	osClearDeadline( board );
+	atomic_set(&desc->io_in_progress, 0);
+	wake_up_interruptible( desc->wait );
+
+	cmd->completed_transfer_count = cmd->requested_transfer_count - remain;
+	if( cmd->write == 0 && cmd->command == 0 )
+		cmd->end = end_flag;
+
+	mutex_lock( &board->big_gpib_mutex );
+	if( desc->is_board ) status_queue = NULL;
+	else status_queue = get_gpib_status_queue( board, desc->pad, desc->sad );
+	cmd->ibsta = general_ibstatus( board, status_queue, retval < 0 ? 0 : DCAS, 0, desc );
+	mutex_unlock( &board->big_gpib_mutex );
+
+	return retval;
+}
+
+/* IBXFER does what used to take a library call a whole series of ioctls:
+ * lock the board, set timeout and eos, address the device, transfer the
+ * data, query the status and unlock the board. */
+static int xfer_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
+	unsigned long arg )
+{
+	xfer_ioctl_t cmd;
+	gpib_descriptor_t *desc;
+	int took_lock = 0;
+	int retval;
+	int fault;
+
+	fault = copy_from_user( &cmd, ( void * ) arg, sizeof( cmd ) );
+	if( fault )
+		return -EFAULT;
+
+	retval = check_xfer_cmd( file_priv, &cmd, &desc );
+	if( retval < 0 ) return retval;
+
+	/* grab the board lock unless we already hold it from an IBMUTEX ioctl */
+	spin_lock(&board->locking_pid_spinlock);
+	if( atomic_read(&file_priv->holding_mutex) == 0 || current->pid != board->locking_pid )
+		took_lock = 1;
+	spin_unlock(&board->locking_pid_spinlock);
+	if( took_lock )
+	{
+		if( mutex_lock_interruptible( &board->user_mutex ) )
+			return -ERESTARTSYS;
+		spin_lock(&board->locking_pid_spinlock);
+		board->locking_pid = current->pid;
+		spin_unlock(&board->locking_pid_spinlock);
+	}
+
+	retval = do_xfer( board, desc, &cmd, NULL );
+
+	if( took_lock )
+	{
+		spin_lock(&board->locking_pid_spinlock);
+		board->locking_pid = 0;
+		spin_unlock(&board->locking_pid_spinlock);
+		mutex_unlock( &board->user_mutex );
+	}
+	if( retval == -ERESTARTSYS ) return retval;
+
+	fault = copy_to_user( ( void * ) arg, &cmd, sizeof( cmd ) );
+	if( fault || retval == -EFAULT ) return -EFAULT;
+
+	return retval;
+}
+
+static void aio_work( struct work_struct *work )
+{
+	struct gpib_aio *aio = container_of( work, struct gpib_aio, work );
+	gpib_board_t *board = aio->board;
+	int cancelled;
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,10,0)
+	mm_segment_t old_fs;
+#endif
+
+	/* don't wait for the board lock if we were cancelled before we started */
+	spin_lock( &aio->lock );
+	cancelled = aio->cancelled;
+	spin_unlock( &aio->lock );
+	if( cancelled )
+	{
+		aio->retval = -ECANCELED;
+		atomic_set( &aio->desc->io_in_progress, 0 );
+		wake_up_interruptible( aio->desc->wait );
+		complete_all( &aio->done );
+		return;
+	}
+
+	/* borrow the submitter's address space so the usual copy_to_user()
+	 * and get_user_pages_fast() paths work on its buffer */
+	kthread_use_mm( aio->mm );
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,10,0)
+	old_fs = get_fs();
+	set_fs( USER_DS );
+#endif
+
+	mutex_lock( &board->user_mutex );
+	spin_lock(&board->locking_pid_spinlock);
+	board->locking_pid = current->pid;
+	spin_unlock(&board->locking_pid_spinlock);
+
+	aio->retval = do_xfer( board, aio->desc, &aio->cmd, aio );
+
+	spin_lock(&board->locking_pid_spinlock);
+	board->locking_pid = 0;
+	spin_unlock(&board->locking_pid_spinlock);
+	mutex_unlock( &board->user_mutex );
+
+#if LINUX_VERSION_CODE < KERNEL_VERSION(5,10,0)
+	set_fs( old_fs );
+#endif
+	kthread_unuse_mm( aio->mm );
+	complete_all( &aio->done );
+}
+
+static void free_aio( struct gpib_aio *aio )
+{
+	mmput( aio->mm );
+	kfree( aio );
+}
+
+/* Cancels and waits for the descriptor's background transfer, if any. */
+static void cleanup_aio( gpib_descriptor_t *desc )
+{
+	if( desc->aio == NULL ) return;
+
+	aio_cancel( desc->aio );
+	wait_for_completion( &desc->aio->done );
+	free_aio( desc->aio );
+	desc->aio = NULL;
+}
+
+static int aio_start_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
+	unsigned long arg )
+{
+	struct gpib_aio *aio;
+	gpib_descriptor_t *desc;
+	int retval;
+
+	aio = kmalloc( sizeof( *aio ), GFP_KERNEL );
+	if( aio == NULL )
+		return -ENOMEM;
 
-	/* Check write access to buffer */
-	if(!access_ok(VERIFY_WRITE, userbuf, remain))
+	retval = copy_from_user( &aio->cmd, ( void * ) arg, sizeof( aio->cmd ) );
+	if( retval )
+	{
+		kfree( aio );
 		return -EFAULT;
+	}
 
-	atomic_set(&desc->io_in_progress, 1);
-
-	/* Read buffer loads till we fill the user supplied buffer */
-	while(remain > 0 && end_flag == 0)
+	retval = check_xfer_cmd( file_priv, &aio->cmd, &desc );
+	if( retval < 0 )
 	{
-		nbytes = 0;
-		read_ret = ibrd(board, board->buffer, (board->buffer_length < remain) ? board->buffer_length :
-			remain, &end_flag, &nbytes);
-		if(nbytes == 0) break;
-		retval = copy_to_user(userbuf, board->buffer, nbytes);
-		if(retval)
-		{
-			retval = -EFAULT;
-			break;
-		}
-		remain -= nbytes;
-		userbuf += nbytes;
-		if(read_ret < 0) break;
+		kfree( aio );
+		return retval;
 	}
-	read_cmd.completed_transfer_count = read_cmd.requested_transfer_count - remain;
-	read_cmd.end = end_flag;
-	/* suppress errors (for example due to timeout or interruption by device clear)
-	if all bytes got sent.  This prevents races that can occur in the various drivers
-	if a device receives a device clear immediately after a transfer completes and
-	the driver code wasn't careful enough to handle that case.
-	*/
-	if(remain == 0 || end_flag)
+
+	INIT_WORK( &aio->work, aio_work );
+	aio->board = board;
+	aio->desc = desc;
+	aio->mm = current->mm;
+	aio->retval = 0;
+	init_completion( &aio->done );
+	spin_lock_init( &aio->lock );
+	aio->cancelled = 0;
+	aio->transferring = 0;
+
+	mutex_lock( &file_priv->descriptors_mutex );
+	if( desc->aio )
 	{
-		read_ret = 0;
+		mutex_unlock( &file_priv->descriptors_mutex );
+		kfree( aio );
+		return -EBUSY;
 	}
-	if(retval == 0)
-		retval = copy_to_user((void*) arg, &read_cmd, sizeof(read_cmd));
-	atomic_set(&desc->io_in_progress, 0);
-	wake_up_interruptible( &board->wait );
-	if(retval) return -EFAULT;
+	mmget( aio->mm );
+	desc->aio = aio;
+	/* CMPL is cleared from now until the worker is done */
+	atomic_set( &desc->io_in_progress, 1 );
+	mutex_unlock( &file_priv->descriptors_mutex );
 
-	return read_ret;
+	queue_work( system_long_wq, &aio->work );
+
+	return 0;
 }
 
-static int command_ioctl( gpib_file_private_t *file_priv,
-	gpib_board_t *board, unsigned long arg)
+static int aio_complete_ioctl( gpib_file_private_t *file_priv, unsigned long arg )
 {
-	read_write_ioctl_t cmd;
-	uint8_t *userbuf;
-	unsigned long remain;
-	int retval;
-	int fault = 0;
+	xfer_ioctl_t cmd;
+	struct gpib_aio *aio = NULL;
 	gpib_descriptor_t *desc;
-	size_t bytes_written;
+	int retval;
 
-	retval = copy_from_user(&cmd, (void*) arg, sizeof(cmd));
+	retval = copy_from_user( &cmd, ( void * ) arg, sizeof( cmd ) );
 	if( retval )
 		return -EFAULT;
 
-	if(cmd.completed_transfer_count > cmd.requested_transfer_count)
-		return -EINVAL;
-
+	mutex_lock( &file_priv->descriptors_mutex );
 	desc = handle_to_descriptor( file_priv, cmd.handle );
+	if( desc ) aio = desc->aio;
+	mutex_unlock( &file_priv->descriptors_mutex );
 	if( desc == NULL ) return -EINVAL;
+	/* nothing started, or already collected */
+	if( aio == NULL ) return -ESRCH;
 
-	userbuf = (uint8_t*)(unsigned long)cmd.buffer_ptr;
-	userbuf += cmd.completed_transfer_count;
-
-	remain = cmd.requested_transfer_count - cmd.completed_transfer_count;
-
-	/* Check read access to buffer */
-	if(!access_ok(VERIFY_READ, userbuf, remain))
-		return -EFAULT;
+	if( wait_for_completion_interruptible( &aio->done ) )
+		return -ERESTARTSYS;
 
-	/* Write buffer loads till we empty the user supplied buffer.
-		Call drivers at least once, even if remain is zero, in
-		order to allow them to insure previous commands were
-		completely finished, in the case of a restarted ioctl.  */
-	atomic_set(&desc->io_in_progress, 1);
-	do 
+	mutex_lock( &file_priv->descriptors_mutex );
+	if( handle_to_descriptor( file_priv, cmd.handle ) != desc || desc->aio != aio )
 	{
-		fault = copy_from_user(board->buffer, userbuf, (board->buffer_length < remain) ?
-			board->buffer_length : remain );
-		if(fault) 
-		{	
-			retval = -EFAULT;
-			bytes_written = 0;
-		}else
-		{
-			retval = ibcmd(board, board->buffer, (board->buffer_length < remain) ?
-				board->buffer_length : remain, &bytes_written );
-		}
-		remain -= bytes_written;
-		userbuf += bytes_written;
-		if(retval < 0)
-		{
-			atomic_set(&desc->io_in_progress, 0);
-			wake_up_interruptible( &board->wait );
-			break;
-		}
-	}while( remain > 0 );
-	
-	cmd.completed_transfer_count = cmd.requested_transfer_count - remain;
+		/* another thread collected it while we were waiting */
+		mutex_unlock( &file_priv->descriptors_mutex );
+		return -ESRCH;
+	}
+	desc->aio = NULL;
+	mutex_unlock( &file_priv->descriptors_mutex );
 
-	if(fault == 0)
-		fault = copy_to_user((void*) arg, &cmd, sizeof(cmd));
-	atomic_set(&desc->io_in_progress, 0);
-	wake_up_interruptible( &board->wait );
-	if( fault ) return -EFAULT;
+	cmd = aio->cmd;
+	retval = aio->retval;
+	free_aio( aio );
+
+	if( copy_to_user( ( void * ) arg, &cmd, sizeof( cmd ) ) )
+		return -EFAULT;
 
 	return retval;
 }
 
-static int write_ioctl(gpib_file_private_t *file_priv, gpib_board_t *board,
-	unsigned long arg)
+static int aio_cancel_ioctl( gpib_file_private_t *file_priv, unsigned long arg )
 {
-	read_write_ioctl_t write_cmd;
-	uint8_t *userbuf;
-	unsigned long remain;
-	int retval = 0;
-	int fault;
 	gpib_descriptor_t *desc;
+	int handle;
+	int retval;
 
-	fault = copy_from_user(&write_cmd, (void*) arg, sizeof(write_cmd));
-	if(fault)
+	retval = copy_from_user( &handle, ( void * ) arg, sizeof( handle ) );
+	if( retval )
 		return -EFAULT;
 
-	if(write_cmd.completed_transfer_count > write_cmd.requested_transfer_count)
-		return -EINVAL;
-
-	desc = handle_to_descriptor( file_priv, write_cmd.handle );
+	mutex_lock( &file_priv->descriptors_mutex );
+	desc = handle_to_descriptor( file_priv, handle );
+	if( desc && desc->aio )
+		aio_cancel( desc->aio );
+	mutex_unlock( &file_priv->descriptors_mutex );
 	if( desc == NULL ) return -EINVAL;
 
-	userbuf = (uint8_t*)(unsigned long)write_cmd.buffer_ptr;
-	userbuf += write_cmd.completed_transfer_count;
-	
-	remain = write_cmd.requested_transfer_count - write_cmd.completed_transfer_count;
-
-	/* Check read access to buffer */
-	if(!access_ok(VERIFY_READ, userbuf, remain))
-		return -EFAULT;
-
-	atomic_set(&desc->io_in_progress, 1);
-
-	/* Write buffer loads till we empty the user supplied buffer */
-	while(remain > 0)
-	{
-		int send_eoi;
-		size_t bytes_written = 0;
-
-		send_eoi = remain <= board->buffer_length && write_cmd.end;
-		fault = copy_from_user(board->buffer, userbuf, (board->buffer_length < remain) ?
-			board->buffer_length : remain );
-		if(fault)
-		{
-			retval = -EFAULT;
-			break;
-		}
-		retval = ibwrt(board, board->buffer, (board->buffer_length < remain) ?
-			board->buffer_length : remain, send_eoi, &bytes_written);
-		remain -= bytes_written;
-		userbuf += bytes_written;
-		if(retval < 0)
-		{
-			break;
-		}
-	}
-	write_cmd.completed_transfer_count = write_cmd.requested_transfer_count - remain;
-	/* suppress errors (for example due to timeout or interruption by device clear)
-	if all bytes got sent.  This prevents races that can occur in the various drivers
-	if a device receives a device clear immediately after a transfer completes and
-	the driver code wasn't careful enough to handle that case.
-	*/
-	if(remain == 0)
-	{
-		retval = 0;
-	}
-	if(fault == 0)
-		fault = copy_to_user((void*) arg, &write_cmd, sizeof(write_cmd));
-	atomic_set(&desc->io_in_progress, 0);
-	wake_up_interruptible( &board->wait );
-	if(fault) return -EFAULT;
-
-	return retval;
+	return 0;
 }
 
 static int status_bytes_ioctl( gpib_board_t *board, unsigned long arg )
@@ -705,11 +1553,13 @@ static int status_bytes_ioctl( gpib_board_t *board, unsigned long arg )
 	if( retval )
 		return -EFAULT;
 
+	spin_lock( &board->status_queue_lock );
 	device = get_gpib_status_queue( board, cmd.pad, cmd.sad );
 	if( device == NULL )
 		cmd.num_bytes = 0;
 	else
 		cmd.num_bytes = num_status_bytes( device );
+	spin_unlock( &board->status_queue_lock );
 
 	retval = copy_to_user( (void *) arg, &cmd, sizeof( cmd ) );
 	if( retval )
@@ -718,35 +1568,36 @@ static int status_bytes_ioctl( gpib_board_t *board, unsigned long arg )
 	return 0;
 }
 
-static int increment_open_device_count( struct list_head *head, unsigned int pad, int sad )
+static int increment_open_device_count( gpib_board_t *board, unsigned int pad, int sad )
 {
-	struct list_head *list_ptr;
 	gpib_status_queue_t *device;
+	int retval;
 
 	/* first see if address has already been opened, then increment
 	 * open count */
-	for( list_ptr = head->next; list_ptr != head; list_ptr = list_ptr->next )
+	device = get_gpib_status_queue( board, pad, sad );
+	if( device )
 	{
-		device = list_entry( list_ptr, gpib_status_queue_t, list );
-		if( gpib_address_equal( device->pad, device->sad, pad, sad ) )
-		{
-			GPIB_DPRINTK( "incrementing open count for pad %i, sad %i\n",
-				device->pad, device->sad );
-			device->reference_count++;
-			return 0;
-		}
+		GPIB_DPRINTK( "incrementing open count for pad %i, sad %i\n",
+			device->pad, device->sad );
+		device->reference_count++;
+		return 0;
 	}
 
 	/* otherwise we need to allocate a new gpib_status_queue_t */
-	device = kmalloc( sizeof( gpib_status_queue_t ), GFP_ATOMIC );
+	device = alloc_gpib_status_queue( GFP_ATOMIC );
 	if( device == NULL )
 		return -ENOMEM;
-	init_gpib_status_queue( device );
 	device->pad = pad;
 	device->sad = sad;
 	device->reference_count = 1;
 
-	list_add( &device->list, head );
+	retval = insert_gpib_status_queue( board, device );
+	if( retval < 0 )
+	{
+		kfree( device );
+		return retval;
+	}
 
 	GPIB_DPRINTK( "opened pad %i, sad %i\n",
 		device->pad, device->sad );
@@ -754,41 +1605,37 @@ static int increment_open_device_count( struct list_head *head, unsigned int pad
 	return 0;
 }
 
-static int subtract_open_device_count( struct list_head *head, unsigned int pad, int sad, unsigned int count )
+static int subtract_open_device_count( gpib_board_t *board, unsigned int pad, int sad, unsigned int count )
 {
 	gpib_status_queue_t *device;
-	struct list_head *list_ptr;
 
-	for( list_ptr = head->next; list_ptr != head; list_ptr = list_ptr->next )
+	device = get_gpib_status_queue( board, pad, sad );
+	if( device == NULL )
 	{
-		device = list_entry( list_ptr, gpib_status_queue_t, list );
-		if( gpib_address_equal( device->pad, device->sad, pad, sad ) )
-		{
-			GPIB_DPRINTK( "decrementing open count for pad %i, sad %i\n",
-				device->pad, device->sad );
-			if( count > device->reference_count )
-			{
-				printk( "gpib: bug! in subtract_open_device_count()\n" );
-				return -EINVAL;
-			}
-			device->reference_count -= count;
-			if( device->reference_count == 0 )
-			{
-				GPIB_DPRINTK( "closing pad %i, sad %i\n",
-					device->pad, device->sad );
-				list_del( list_ptr );
-				kfree( device );
-			}
-			return 0;
-		}
+		printk( "gpib: bug! tried to close address that was never opened!\n" );
+		return -EINVAL;
 	}
-	printk( "gpib: bug! tried to close address that was never opened!\n" );
-	return -EINVAL;
+	GPIB_DPRINTK( "decrementing open count for pad %i, sad %i\n",
+		device->pad, device->sad );
+	if( count > device->reference_count )
+	{
+		printk( "gpib: bug! in subtract_open_device_count()\n" );
+		return -EINVAL;
+	}
+	device->reference_count -= count;
+	if( device->reference_count == 0 )
+	{
+		GPIB_DPRINTK( "closing pad %i, sad %i\n",
+			device->pad, device->sad );
+		remove_gpib_status_queue( board, device );
+		kfree( device );
+	}
+	return 0;
 }
 
-static inline int decrement_open_device_count( struct list_head *head, unsigned int pad, int sad )
+static inline int decrement_open_device_count( gpib_board_t *board, unsigned int pad, int sad )
 {
-	return subtract_open_device_count( head, pad, sad, 1 );
+	return subtract_open_device_count( board, pad, sad, 1 );
 }
 
 static int cleanup_open_devices( gpib_file_private_t *file_priv, gpib_board_t *board )
@@ -803,10 +1650,14 @@ static int cleanup_open_devices( gpib_file_private_t *file_priv, gpib_board_t *b
 		desc = file_priv->descriptors[ i ];
 		if( desc == NULL ) continue;
 
+		cleanup_aio( desc );
 		if( desc->is_board == 0 )
 		{
-			retval = decrement_open_device_count( &board->device_list, desc->pad,
+			/* an ibwait() may be using the status queue */
+			mutex_lock( &board->big_gpib_mutex );
+			retval = decrement_open_device_count( board, desc->pad,
 				desc->sad );
+			mutex_unlock( &board->big_gpib_mutex );
 			if( retval < 0 ) return retval;
 		}
 		kfree( desc );
@@ -826,6 +1677,8 @@ static int open_dev_ioctl( struct file *filep, gpib_board_t *board, unsigned lon
 	retval = copy_from_user( &open_dev_cmd, ( void* ) arg, sizeof( open_dev_cmd ) );
 	if (retval)
 		return -EFAULT;
+	if( open_dev_cmd.pad > gpib_addr_max || open_dev_cmd.sad > gpib_addr_max )
+		return -EINVAL;
 
 	if(mutex_lock_interruptible(&file_priv->descriptors_mutex))
 	{
@@ -842,13 +1695,14 @@ static int open_dev_ioctl( struct file *filep, gpib_board_t *board, unsigned lon
 		return -ENOMEM;
 	}
 	init_gpib_descriptor( file_priv->descriptors[ i ] );
+	file_priv->descriptors[ i ]->wait = &file_priv->wait;
 
 	file_priv->descriptors[ i ]->pad = open_dev_cmd.pad;
 	file_priv->descriptors[ i ]->sad = open_dev_cmd.sad;
 	file_priv->descriptors[ i ]->is_board = open_dev_cmd.is_board;
 	mutex_unlock(&file_priv->descriptors_mutex);
 
-	retval = increment_open_device_count( &board->device_list, open_dev_cmd.pad, open_dev_cmd.sad );
+	retval = increment_open_device_count( board, open_dev_cmd.pad, open_dev_cmd.sad );
 	if( retval < 0 )
 		return retval;
 
@@ -876,8 +1730,10 @@ static int close_dev_ioctl( struct file *filep, gpib_board_t *board, unsigned lo
 
 	if( cmd.handle >= GPIB_MAX_NUM_DESCRIPTORS ) return -EINVAL;
 	if( file_priv->descriptors[ cmd.handle ] == NULL ) return -EINVAL;
+	/* background transfer has to be collected with IBAIO_COMPLETE first */
+	if( file_priv->descriptors[ cmd.handle ]->aio ) return -EBUSY;
 
-	retval = decrement_open_device_count( &board->device_list, file_priv->descriptors[ cmd.handle ]->pad,
+	retval = decrement_open_device_count( board, file_priv->descriptors[ cmd.handle ]->pad,
 		file_priv->descriptors[ cmd.handle ]->sad );
 	if( retval < 0 ) return retval;
 
@@ -910,6 +1766,81 @@ static int serial_poll_ioctl( gpib_board_t *board, unsigned long arg )
 	return 0;
 }
 
+static int serial_poll_list_ioctl( gpib_board_t *board, unsigned long arg )
+{
+	serial_poll_list_ioctl_t cmd;
+	serial_poll_ioctl_t *polls;
+	serial_poll_ioctl_t *user_polls;
+	unsigned int i;
+	int retval;
+
+	retval = copy_from_user( &cmd, ( void* ) arg, sizeof( cmd ) );
+	if( retval )
+		return -EFAULT;
+
+	/* allow one entry for every possible primary/secondary address combination */
+	if( cmd.num_polls == 0 || cmd.num_polls > ( gpib_addr_max + 1 ) * ( gpib_addr_max + 2 ) )
+		return -EINVAL;
+
+	if( ( ibstatus( board ) & CIC ) == 0 )
+	{
+		printk("gpib: not CIC during serial poll\n");
+		return -EIO;
+	}
+
+	polls = kmalloc( cmd.num_polls * sizeof( serial_poll_ioctl_t ), GFP_KERNEL );
+	if( polls == NULL )
+		return -ENOMEM;
+	user_polls = ( serial_poll_ioctl_t * ) ( unsigned long ) cmd.poll_list_ptr;
+	if( copy_from_user( polls, user_polls, cmd.num_polls * sizeof( serial_poll_ioctl_t ) ) )
+	{
+		kfree( polls );
+		return -EFAULT;
+	}
+	for( i = 0; i < cmd.num_polls; i++ )
+	{
+		if( polls[ i ].pad > gpib_addr_max || polls[ i ].sad > gpib_addr_max )
+		{
+			kfree( polls );
+			return -EINVAL;
+		}
+	}
+
+	retval = serial_poll_list( board, polls, cmd.num_polls, cmd.usec_timeout,
+		cmd.stop_on_rqs, &cmd.num_completed );
+
+	/* copy back whatever got polled, even on error */
+	if( copy_to_user( user_polls, polls, cmd.num_completed * sizeof( serial_poll_ioctl_t ) ) ||
+		copy_to_user( ( void * ) arg, &cmd, sizeof( cmd ) ) )
+		retval = -EFAULT;
+	kfree( polls );
+
+	return retval;
+}
+
+static int poll_mask_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
+	unsigned long arg )
+{
+	poll_mask_ioctl_t cmd;
+	gpib_descriptor_t *desc;
+	int retval;
+
+	retval = copy_from_user( &cmd, ( void * ) arg, sizeof( cmd ) );
+	if( retval )
+		return -EFAULT;
+
+	desc = handle_to_descriptor( file_priv, cmd.handle );
+	if( desc == NULL ) return -EINVAL;
+	/* poll() has no timeout of its own */
+	if( cmd.wait_mask & TIMO ) return -EINVAL;
+
+	desc->poll_mask = cmd.wait_mask;
+	/* let anyone already sleeping in poll() see the new mask */
+	wake_up_interruptible( desc->wait );
+
+	return 0;
+}
+
 static int wait_ioctl( gpib_file_private_t *file_priv, gpib_board_t *board,
 	unsigned long arg )
 {
@@ -1055,13 +1986,14 @@ static int pad_ioctl( gpib_board_t *board, gpib_file_private_t *file_priv,
 		if( retval < 0 ) return retval;
 	}else
 	{
-		retval = decrement_open_device_count( &board->device_list, desc->pad, desc->sad );
+		if( cmd.pad > gpib_addr_max ) return -EINVAL;
+		retval = decrement_open_device_count( board, desc->pad, desc->sad );
 		if( retval < 0 )
 			return retval;
 
 		desc->pad = cmd.pad;
 
-		retval = increment_open_device_count( &board->device_list, desc->pad, desc->sad );
+		retval = increment_open_device_count( board, desc->pad, desc->sad );
 		if( retval < 0 )
 			return retval;
 	}
@@ -1090,13 +2022,14 @@ static int sad_ioctl( gpib_board_t *board, gpib_file_private_t *file_priv,
 		if( retval < 0 ) return retval;
 	}else
 	{
-		retval = decrement_open_device_count( &board->device_list, desc->pad, desc->sad );
+		if( cmd.sad > gpib_addr_max ) return -EINVAL;
+		retval = decrement_open_device_count( board, desc->pad, desc->sad );
 		if( retval < 0 )
 			return retval;
 
 		desc->sad = cmd.sad;
 
-		retval = increment_open_device_count( &board->device_list, desc->pad, desc->sad );
+		retval = increment_open_device_count( board, desc->pad, desc->sad );
 		if( retval < 0 )
 			return retval;
 	}
@@ -1205,6 +2138,7 @@ static int autospoll_ioctl(gpib_board_t *board, unsigned long arg)
 			retval = 0;
 		}
 	}
+	board_info_changed( board );
 	return retval;
 }
 
@@ -1265,6 +2199,7 @@ static int timeout_ioctl( gpib_board_t *board, unsigned long arg )
 		return -EFAULT;
 
 	board->usec_timeout = timeout;
+	board_timeout_changed( board );
 	GPIB_DPRINTK( "timeout set to %i usec\n", timeout );
 
 	return 0;
@@ -1283,10 +2218,12 @@ static int ppc_ioctl( gpib_board_t *board, unsigned long arg)
 	{
 		board->ist = 1;
 		board->interface->parallel_poll_response( board, board->ist );
+		board_info_changed( board );
 	}else if( cmd.clear_ist )
 	{
 		board->ist = 0;
 		board->interface->parallel_poll_response( board, board->ist );
+		board_info_changed( board );
 	}
 
 	if( cmd.config )
@@ -1315,19 +2252,14 @@ static int query_board_rsv_ioctl( gpib_board_t *board, unsigned long arg )
 static int board_info_ioctl( const gpib_board_t *board, unsigned long arg)
 {
 	board_info_ioctl_t info;
+	unsigned int seq;
 	int retval;
 
-	info.pad = board->pad;
-	info.sad = board->sad;
-	info.parallel_poll_configuration = board->parallel_poll_configuration;
-	info.is_system_controller = board->master;
-	if( board->autospollers )
-		info.autopolling = 1;
-	else
-		info.autopolling = 0;
-	info.t1_delay = board->t1_nano_sec;
-	info.ist = board->ist;
-	info.no_7_bit_eos = board->interface->no_7_bit_eos;
+	do
+	{
+		seq = read_seqbegin( &board->info_seqlock );
+		info = board->info;
+	}while( read_seqretry( &board->info_seqlock, seq ) );
 	retval = copy_to_user( ( void * ) arg, &info, sizeof( info ) );
 	if( retval )
 		return -EFAULT;
@@ -1335,6 +2267,99 @@ static int board_info_ioctl( const gpib_board_t *board, unsigned long arg)
 	return 0;
 }
 
+/* upper limit on transfer buffer lengths, since vmalloc space is limited */
+static const unsigned int buffer_length_limit = 0x1000000;
+
+static int buffer_size_ioctl( gpib_board_t *board, unsigned long arg )
+{
+	buffer_size_ioctl_t cmd;
+	int retval;
+
+	retval = copy_from_user( &cmd, ( void * ) arg, sizeof( cmd ) );
+	if( retval )
+		return -EFAULT;
+
+	if( cmd.buffer_length > buffer_length_limit || cmd.max_buffer_length > buffer_length_limit )
+	{
+		printk( "gpib: invalid buffer length\n" );
+		return -EINVAL;
+	}
+
+	/* waits for io using the current buffer to finish */
+	down_write( &board->buffer_rwsem );
+	mutex_lock( &board->big_gpib_mutex );
+	/* zero buffer_length leaves the current length alone, even if the
+	 * buffer has grown past initial_buffer_length */
+	if( cmd.buffer_length == 0 )
+		cmd.buffer_length = board->buffer ? board->buffer_length : board->initial_buffer_length;
+	else
+		board->initial_buffer_length = cmd.buffer_length;
+	if( cmd.max_buffer_length < cmd.buffer_length )
+		cmd.max_buffer_length = cmd.buffer_length;
+	board->max_buffer_length = cmd.max_buffer_length;
+	retval = gpib_resize_buffer( board, cmd.buffer_length );
+	board_info_changed( board );
+	mutex_unlock( &board->big_gpib_mutex );
+	up_write( &board->buffer_rwsem );
+
+	return retval;
+}
+
+static int pseudo_irq_ioctl( gpib_board_t *board, unsigned long arg )
+{
+	pseudo_irq_ioctl_t cmd;
+	struct gpib_pseudo_irq *pseudo_irq = &board->pseudo_irq;
+	static const int period_limit = 1000000;
+	int retval;
+
+	retval = copy_from_user( &cmd, ( void * ) arg, sizeof( cmd ) );
+	if( retval )
+		return -EFAULT;
+
+	if( cmd.min_period_usec < 0 )
+		cmd.min_period_usec = pseudo_irq->min_period_usec;
+	if( cmd.max_period_usec < 0 )
+		cmd.max_period_usec = pseudo_irq->max_period_usec;
+	if( cmd.busy_poll_usec < 0 )
+		cmd.busy_poll_usec = pseudo_irq->busy_poll_usec;
+	if( cmd.min_period_usec == 0 || cmd.max_period_usec > period_limit ||
+		cmd.min_period_usec > cmd.max_period_usec )
+	{
+		printk( "gpib: invalid pseudo irq period\n" );
+		return -EINVAL;
+	}
+	/* no point spinning longer than the timer would take to poll again */
+	if( cmd.busy_poll_usec > cmd.min_period_usec )
+		cmd.busy_poll_usec = cmd.min_period_usec;
+
+	/* a running pseudo irq timer picks these up on its next tick */
+	pseudo_irq->min_period_usec = cmd.min_period_usec;
+	pseudo_irq->max_period_usec = cmd.max_period_usec;
+	pseudo_irq->busy_poll_usec = cmd.busy_poll_usec;
+
+	return 0;
+}
+
+static int pio_poll_ioctl( gpib_board_t *board, unsigned long arg )
+{
+	unsigned int usec;
+	static const unsigned int usec_limit = 1000;
+	int retval;
+
+	retval = copy_from_user( &usec, ( void * ) arg, sizeof( usec ) );
+	if( retval )
+		return -EFAULT;
+
+	if( usec > usec_limit )
+	{
+		printk( "gpib: invalid pio poll window\n" );
+		return -EINVAL;
+	}
+	board->pio_poll_usec = usec;
+
+	return 0;
+}
+
 static int interface_clear_ioctl( gpib_board_t *board, unsigned long arg )
 {
 	unsigned int usec_duration;
@@ -1412,6 +2437,7 @@ static int t1_delay_ioctl( gpib_board_t *board, unsigned long arg )
 	delay = cmd;
 
 	board->t1_nano_sec = board->interface->t1_delay( board, delay );
+	board_info_changed( board );
 
 	return 0;
 }
@@ -30,6 +30,16 @@
 MODULE_LICENSE("GPL");
 MODULE_ALIAS_CHARDEV_MAJOR(IBMAJOR);
 
+static unsigned int event_queue_depth = 1024;
+module_param(event_queue_depth, uint, 0444);
+MODULE_PARM_DESC(event_queue_depth, "number of device mode events queued per board");
+static unsigned int status_byte_queue_depth = 1024;
+module_param(status_byte_queue_depth, uint, 0444);
+MODULE_PARM_DESC(status_byte_queue_depth, "number of autopolled status bytes queued per device");
+static bool queue_drop_newest = 0;
+module_param(queue_drop_newest, bool, 0444);
+MODULE_PARM_DESC(queue_drop_newest, "when an event or status byte queue is full, drop the new entry instead of the oldest");
+
 struct file_operations ib_fops =
 {
 	owner: THIS_MODULE,
@@ -38,6 +48,8 @@ struct file_operations ib_fops =
 	compat_ioctl: &ibioctl,
 	open: &ibopen,
 	release: &ibclose,
+	mmap: &ibmmap,
+	poll: &ibpoll,
 };
 
 gpib_board_t board_array[GPIB_MAX_NUM_BOARDS];
@@ -49,6 +61,9 @@ void init_gpib_descriptor( gpib_descriptor_t *desc )
 	desc->pad = 0;
 	desc->sad = -1;
 	desc->is_board = 0;
+	desc->poll_mask = 0;
+	desc->aio = NULL;
+	desc->wait = NULL;
 	atomic_set(&desc->io_in_progress, 0);
 }
 
@@ -107,14 +122,20 @@ void init_gpib_board( gpib_board_t *board )
 	board->provider_module = NULL;
 	board->buffer = NULL;
 	board->buffer_length = 0;
+	board->initial_buffer_length = 0x4000;
+	board->max_buffer_length = board->initial_buffer_length;
+	board->large_transfer_count = 0;
+	init_rwsem(&board->buffer_rwsem);
 	board->status = 0;
 	init_waitqueue_head(&board->wait);
+	init_waitqueue_head(&board->rqs_wait);
 	mutex_init(&board->user_mutex);
 	mutex_init(&board->big_gpib_mutex);
+	init_rwsem(&board->attach_rwsem);
 	board->locking_pid = 0;
 	spin_lock_init(&board->locking_pid_spinlock);
 	spin_lock_init(&board->spinlock);
-	init_timer(&board->timer);
+	osInitTimer(board);
 	board->ibbase = 0;
 	board->ibirq = 0;
 	board->ibdma = 0;
@@ -123,6 +144,10 @@ void init_gpib_board( gpib_board_t *board )
 	board->private_data = NULL;
 	board->use_count = 0;
 	INIT_LIST_HEAD( &board->device_list );
+	memset( board->device_table, 0, sizeof( board->device_table ) );
+	spin_lock_init( &board->status_queue_lock );
+	seqlock_init( &board->info_seqlock );
+	board->state_page = NULL;
 	board->pad = 0;
 	board->sad = -1;
 	board->usec_timeout = 3000000;
@@ -133,28 +158,68 @@ void init_gpib_board( gpib_board_t *board )
 	init_event_queue(&board->event_queue);
 	board->minor = -1;
 	init_gpib_pseudo_irq(&board->pseudo_irq);
+	board->pio_poll_usec = 20;
 	board->master = 1;
 	atomic_set(&board->stuck_srq, 0);
+	board_info_changed( board );
 }
 
 int gpib_allocate_board( gpib_board_t *board )
 {
 	if( board->buffer == NULL )
 	{
-		board->buffer_length = 0x4000;
+		board->buffer_length = board->initial_buffer_length;
 		board->buffer = vmalloc( board->buffer_length );
 		if(board->buffer == NULL)
 		{
 			board->buffer_length = 0;
 			return -ENOMEM;
 		}
+		board->large_transfer_count = 0;
+	}
+	if( board->event_queue.events == NULL )
+	{
+		gpib_event_queue_t *queue = &board->event_queue;
+		unsigned int depth = event_queue_depth ? event_queue_depth : 1;
+		short *events;
+		unsigned long flags;
+
+		events = kmalloc( depth * sizeof( short ), GFP_KERNEL );
+		if( events == NULL ) return -ENOMEM;
+		spin_lock_irqsave( &queue->lock, flags );
+		queue->events = events;
+		queue->size = depth;
+		queue->front = 0;
+		queue->num_events = 0;
+		queue->dropped_event = 0;
+		queue->drop_newest = queue_drop_newest;
+		spin_unlock_irqrestore( &queue->lock, flags );
 	}
 	return 0;
 }
 
+/* Replaces the transfer buffer of an online board with one of a different
+ * length.  The old buffer is kept if the allocation fails.  Caller must
+ * hold board->buffer_rwsem for writing, and board->big_gpib_mutex. */
+int gpib_resize_buffer( gpib_board_t *board, unsigned int length )
+{
+	uint8_t *buffer;
+
+	if( board->buffer == NULL || board->buffer_length == length ) return 0;
+	buffer = vmalloc( length );
+	if( buffer == NULL ) return -ENOMEM;
+	vfree( board->buffer );
+	board->buffer = buffer;
+	board->buffer_length = length;
+	board->large_transfer_count = 0;
+	return 0;
+}
+
 void gpib_deallocate_board( gpib_board_t *board )
 {
-	short dummy;
+	gpib_event_queue_t *queue = &board->event_queue;
+	short *events;
+	unsigned long flags;
 
 	if( board->buffer )
 	{
@@ -163,9 +228,14 @@ void gpib_deallocate_board( gpib_board_t *board )
 		board->buffer_length = 0;
 	}
 
-	while( num_gpib_events( &board->event_queue ) )
-		pop_gpib_event( &board->event_queue, &dummy );
-
+	spin_lock_irqsave( &queue->lock, flags );
+	events = queue->events;
+	queue->events = NULL;
+	queue->size = 0;
+	queue->num_events = 0;
+	queue->dropped_event = 0;
+	spin_unlock_irqrestore( &queue->lock, flags );
+	kfree( events );
 }
 
 void init_board_array( gpib_board_t *board_array, unsigned int length )
@@ -178,13 +248,49 @@ void init_board_array( gpib_board_t *board_array, unsigned int length )
 	}
 }
 
-void init_gpib_status_queue( gpib_status_queue_t *device )
+static int allocate_state_pages( gpib_board_t *board_array, unsigned int length )
 {
+	int i;
+	for( i = 0; i < length; i++ )
+	{
+		board_array[i].state_page = (void*) get_zeroed_page( GFP_KERNEL );
+		if( board_array[i].state_page == NULL )
+			return -ENOMEM;
+		SetPageReserved( virt_to_page( board_array[i].state_page ) );
+	}
+	return 0;
+}
+
+static void free_state_pages( gpib_board_t *board_array, unsigned int length )
+{
+	int i;
+	for( i = 0; i < length; i++ )
+	{
+		if( board_array[i].state_page == NULL ) continue;
+		ClearPageReserved( virt_to_page( board_array[i].state_page ) );
+		free_page( (unsigned long) board_array[i].state_page );
+		board_array[i].state_page = NULL;
+	}
+}
+
+/* The status byte ring is allocated in the same block as the
+ * gpib_status_queue_t, so a plain kfree() releases both. */
+gpib_status_queue_t *alloc_gpib_status_queue( gfp_t gfp_flags )
+{
+	gpib_status_queue_t *device;
+	unsigned int depth = status_byte_queue_depth ? status_byte_queue_depth : 1;
+
+	device = kmalloc( sizeof( gpib_status_queue_t ) + depth, gfp_flags );
+	if( device == NULL ) return NULL;
 	INIT_LIST_HEAD( &device->list );
-	INIT_LIST_HEAD( &device->status_bytes );
+	device->status_bytes = ( uint8_t * ) ( device + 1 );
+	device->size = depth;
+	device->front = 0;
 	device->num_status_bytes = 0;
 	device->reference_count = 0;
 	device->dropped_byte = 0;
+	device->drop_newest = queue_drop_newest;
+	return device;
 }
 
 static struct class *gpib_class;
@@ -194,9 +300,16 @@ static int __init gpib_common_init_module( void )
 	int i;
 	printk("Linux-GPIB %s Driver\n", VERSION);
 	init_board_array(board_array, GPIB_MAX_NUM_BOARDS);
+	if(allocate_state_pages(board_array, GPIB_MAX_NUM_BOARDS))
+	{
+		printk("gpib: failed to allocate board state pages\n");
+		free_state_pages(board_array, GPIB_MAX_NUM_BOARDS);
+		return -ENOMEM;
+	}
 	if(register_chrdev(IBMAJOR, "gpib", &ib_fops))
 	{
 		printk( "gpib: can't get major %d\n", IBMAJOR );
+		free_state_pages(board_array, GPIB_MAX_NUM_BOARDS);
 		return -EIO;
 	}
 	gpib_class = class_create(THIS_MODULE, "gpib_common");
@@ -204,6 +317,7 @@ static int __init gpib_common_init_module( void )
 	{
 		printk("gpib: failed to create gpib class\n");
 		unregister_chrdev(IBMAJOR, "gpib");
+		free_state_pages(board_array, GPIB_MAX_NUM_BOARDS);
 		return PTR_ERR(gpib_class);
 	}
 	for(i = 0; i < GPIB_MAX_NUM_BOARDS; ++i)
@@ -222,6 +336,7 @@ static void __exit gpib_common_exit_module( void )
 	}
 	class_destroy(gpib_class);
 	unregister_chrdev(IBMAJOR, "gpib");
+	free_state_pages(board_array, GPIB_MAX_NUM_BOARDS);
 }
 
 module_init( gpib_common_init_module );
@@ -20,40 +20,94 @@
 /*
  * Timer functions
  */
-void watchdog_timeout( unsigned long arg )
+static enum hrtimer_restart watchdog_timeout( struct hrtimer *timer )
 /* Watchdog timeout routine */
 {
-	gpib_board_t *board = (gpib_board_t*) arg;
+	gpib_board_t *board = container_of( timer, gpib_board_t, timer );
 
 	set_bit( TIMO_NUM, &board->status );
 	wake_up_interruptible( &board->wait );
+	return HRTIMER_NORESTART;
+}
+
+void osInitTimer( gpib_board_t *board )
+{
+	hrtimer_init( &board->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS );
+	board->timer.function = watchdog_timeout;
+	board->deadline_active = 0;
+	atomic_set( &board->io_aborted, 0 );
 }
 
 /* install timer interrupt handler */
 void osStartTimer( gpib_board_t *board, unsigned int usec_timeout )
 /* Starts the timeout task  */
 {
-	if( timer_pending( &board->timer ) )
+	ktime_t expires;
+
+	if( hrtimer_active( &board->timer ) )
 	{
 		printk("gpib: bug! timer already running?\n");
 		return;
 	}
 	clear_bit( TIMO_NUM, &board->status );
 
+	if( atomic_read( &board->io_aborted ) )
+	{
+		set_bit( TIMO_NUM, &board->status );
+		return;
+	}
+	if( usec_timeout == 0 && board->deadline_active == 0 ) return;
 	if( usec_timeout > 0 )
 	{
-		board->timer.expires = jiffies + usec_to_jiffies( usec_timeout );   /* set number of ticks */
-		board->timer.function = watchdog_timeout;
-		board->timer.data = (unsigned long) board;
-		add_timer( &board->timer );              /* add timer           */
+		expires = ktime_add_us( ktime_get(), usec_timeout );
+		if( board->deadline_active && ktime_to_ns( board->deadline ) < ktime_to_ns( expires ) )
+			expires = board->deadline;
+	}else
+		expires = board->deadline;
+
+	if( ktime_to_ns( expires ) <= ktime_to_ns( ktime_get() ) )
+	{
+		set_bit( TIMO_NUM, &board->status );
+		return;
 	}
+	hrtimer_start( &board->timer, expires, HRTIMER_MODE_ABS );
 }
 
 void osRemoveTimer( gpib_board_t *board )
 /* Removes the timeout task */
 {
-	if( timer_pending( &board->timer ) )
-		del_timer_sync( &board->timer );
+	hrtimer_cancel( &board->timer );
+}
+
+/* Sets a deadline, usec_timeout from now, which caps every watchdog started
+ * until osClearDeadline() is called.  This keeps an io ioctl which is split
+ * into several ibcmd()/ibrd()/ibwrt() calls from taking longer than the
+ * board's timeout in total. */
+void osSetDeadline( gpib_board_t *board, unsigned int usec_timeout )
+{
+	if( usec_timeout == 0 )
+	{
+		board->deadline_active = 0;
+		return;
+	}
+	board->deadline = ktime_add_us( ktime_get(), usec_timeout );
+	board->deadline_active = 1;
+}
+
+void osClearDeadline( gpib_board_t *board )
+{
+	board->deadline_active = 0;
+	atomic_set( &board->io_aborted, 0 );
+}
+
+/* Makes the io ioctl in progress on the board, and every watchdog it starts
+ * until osClearDeadline() is called, time out immediately.  Used to cancel
+ * background transfers. */
+void osAbortIo( gpib_board_t *board )
+{
+	atomic_set( &board->io_aborted, 1 );
+	set_bit( TIMO_NUM, &board->status );
+	wake_up_interruptible( &board->wait );
 }
 
 int io_timed_out( gpib_board_t *board )
@@ -3,81 +3,95 @@
 #include <asm/io.h>
 #include <linux/sched.h>
 
-void writeb_wrapper(unsigned int value, void *address)
+/* Calls the handler once, and returns nonzero if it found something to
+ * handle.  Counting wakeups on board->wait instead doesn't work, since
+ * poll() and other long lived waiters stay on the queue. */
+static int pseudo_irq_poll_once(gpib_board_t *board)
 {
-	writeb(value, address);
-};
+	irqreturn_t (*handler)(int, void * PT_REGS_ARG) = board->pseudo_irq.handler;
 
-void writew_wrapper(unsigned int value, void *address)
-{
-	writew(value, address);
-};
-
-unsigned int readb_wrapper(void *address)
-{
-	return readb(address);
-};
-
-unsigned int readw_wrapper(void *address)
-{
-	return readw(address);
-};
-
-void outb_wrapper(unsigned int value, void *address)
-{
-	outb(value, (unsigned long)(address));
-};
+	if(handler == NULL)
+		return 0;
+	return handler(0, board
+#ifdef HAVE_PT_REGS
+		, NULL
+#endif
+		) == IRQ_HANDLED;
+}
 
-void outw_wrapper(unsigned int value, void *address)
+static enum hrtimer_restart pseudo_irq_handler(struct hrtimer *timer)
 {
-	outw(value, (unsigned long)(address));
-};
+	gpib_board_t *board = container_of(timer, gpib_board_t, pseudo_irq.timer);
+	struct gpib_pseudo_irq *pseudo_irq = &board->pseudo_irq;
+	unsigned int max_period = pseudo_irq->max_period_usec;
+	int handled;
 
-unsigned int inb_wrapper(void *address)
-{
-	return inb((unsigned long)(address));
-};
+	if(pseudo_irq->handler == NULL)
+	{
+		printk("gpib: bug! pseudo_irq.handler is NULL\n");
+		return HRTIMER_NORESTART;
+	}
+	handled = pseudo_irq_poll_once(board);
+	if(atomic_xchg(&pseudo_irq->busy_poll_handled, 0))
+		handled = 1;
+	/* with a real irq, transfers don't depend on how often we poll */
+	if(pseudo_irq->replaces_irq == 0)
+		pseudo_irq->period_usec = max_period;
+	else if(handled)
+		pseudo_irq->period_usec = pseudo_irq->min_period_usec;
+	else if(pseudo_irq->period_usec < max_period / 2)
+		pseudo_irq->period_usec *= 2;
+	else
+		pseudo_irq->period_usec = max_period;
 
-unsigned int inw_wrapper(void *address)
-{
-	return inw((unsigned long)(address));
-};
-/* this is a function instead of a constant because of Suse
- * defining HZ to be a function call to get_hz() */
-static inline int pseudo_irq_period(void)
-{
-	return (HZ + 99) / 100;
+	if(atomic_read(&pseudo_irq->active) == 0)
+		return HRTIMER_NORESTART;
+	hrtimer_forward_now(timer, ktime_set(0, pseudo_irq->period_usec * 1000UL));
+	return HRTIMER_RESTART;
 }
 
-void pseudo_irq_handler(unsigned long arg)
+/* For drivers about to sleep on board->wait waiting for a byte handshake.
+ * If the pseudo irq replaces a missing irq, calls the handler from the
+ * caller's context for up to busy_poll_usec, so a handshake completing just
+ * after a timer tick isn't left for the next one.  Does nothing unless
+ * pseudo_irq.replaces_irq is set, even if the board polls for other reasons.
+ * Returns nonzero if the handler handled something. */
+int gpib_pseudo_irq_busy_poll(gpib_board_t *board)
 {
-	gpib_board_t *board = (gpib_board_t*) arg;
-	if(board->pseudo_irq.handler)
-		board->pseudo_irq.handler(0, board
-#ifdef HAVE_PT_REGS
-		, NULL
-#endif
-		);
-	else
-		printk("gpib: bug! pseudo_irq.handler is NULL\n");
-	if(atomic_read(&board->pseudo_irq.active))
-		mod_timer(&board->pseudo_irq.timer, jiffies + pseudo_irq_period());
+	struct gpib_pseudo_irq *pseudo_irq = &board->pseudo_irq;
+	ktime_t stop;
+
+	if(atomic_read(&pseudo_irq->active) == 0 || pseudo_irq->replaces_irq == 0 ||
+		pseudo_irq->busy_poll_usec == 0)
+		return 0;
+	stop = ktime_add_us(ktime_get(), pseudo_irq->busy_poll_usec);
+	do
+	{
+		if(pseudo_irq_poll_once(board))
+		{
+			/* a transfer is running, have the timer poll it as often as it may */
+			atomic_set(&pseudo_irq->busy_poll_handled, 1);
+			return 1;
+		}
+		cpu_relax();
+	}while(ktime_to_ns(ktime_get()) < ktime_to_ns(stop));
+	return 0;
 }
 
 int gpib_request_pseudo_irq(gpib_board_t *board, irqreturn_t (*handler)(int, void * PT_REGS_ARG))
 {
-	if(timer_pending(&board->pseudo_irq.timer) || board->pseudo_irq.handler)
+	if(hrtimer_active(&board->pseudo_irq.timer) || board->pseudo_irq.handler)
 	{
 		printk("gpib: only one psuedo interrupt per board allowed\n");
 		return -1;
 	}
 
 	board->pseudo_irq.handler = handler;
-	board->pseudo_irq.timer.expires = jiffies + pseudo_irq_period();
 	board->pseudo_irq.timer.function = pseudo_irq_handler;
-	board->pseudo_irq.timer.data = (unsigned long) board;
+	board->pseudo_irq.period_usec = board->pseudo_irq.max_period_usec;
 	atomic_set(&board->pseudo_irq.active, 1);
-	add_timer(&board->pseudo_irq.timer);
+	hrtimer_start(&board->pseudo_irq.timer,
+		ktime_set(0, board->pseudo_irq.period_usec * 1000UL), HRTIMER_MODE_REL);
 
 	return 0;
 }
@@ -85,17 +99,11 @@ int gpib_request_pseudo_irq(gpib_board_t *board, irqreturn_t (*handler)(int, voi
 void gpib_free_pseudo_irq(gpib_board_t *board)
 {
 	atomic_set(&board->pseudo_irq.active, 0);
-	del_timer_sync(&board->pseudo_irq.timer);
+	hrtimer_cancel(&board->pseudo_irq.timer);
 	board->pseudo_irq.handler = NULL;
+	board->pseudo_irq.replaces_irq = 0;
 }
 
-EXPORT_SYMBOL( writeb_wrapper );
-EXPORT_SYMBOL( readb_wrapper );
-EXPORT_SYMBOL( outb_wrapper );
-EXPORT_SYMBOL( inb_wrapper );
-EXPORT_SYMBOL( writew_wrapper );
-EXPORT_SYMBOL( readw_wrapper );
-EXPORT_SYMBOL( outw_wrapper );
-EXPORT_SYMBOL( inw_wrapper );
 EXPORT_SYMBOL(gpib_request_pseudo_irq);
 EXPORT_SYMBOL(gpib_free_pseudo_irq);
+EXPORT_SYMBOL(gpib_pseudo_irq_busy_poll);
@@ -80,27 +80,23 @@ void tms9914_online( gpib_board_t *board, tms9914_private_t *priv )
 // wrapper for inb
 uint8_t tms9914_ioport_read_byte(tms9914_private_t *priv, unsigned int register_num)
 {
-	return inb((unsigned long)(priv->iobase) + register_num * priv->offset);
+	return tms9914_raw_read_byte(priv, 0, register_num);
 }
 // wrapper for outb
 void tms9914_ioport_write_byte(tms9914_private_t *priv, uint8_t data, unsigned int register_num)
 {
-	outb(data, (unsigned long)(priv->iobase) + register_num * priv->offset);
-	if(register_num == AUXCR)
-		udelay(1);
+	tms9914_raw_write_byte(priv, 0, data, register_num);
 }
 
 // wrapper for readb
 uint8_t tms9914_iomem_read_byte(tms9914_private_t *priv, unsigned int register_num)
 {
-	return readb(priv->iobase + register_num * priv->offset);
+	return tms9914_raw_read_byte(priv, 1, register_num);
 }
 // wrapper for writeb
 void tms9914_iomem_write_byte(tms9914_private_t *priv, uint8_t data, unsigned int register_num)
 {
-	writeb(data, priv->iobase + register_num * priv->offset);
-	if(register_num == AUXCR)
-		udelay(1);
+	tms9914_raw_write_byte(priv, 1, data, register_num);
 }
 
 static int __init tms9914_init_module(void)
@@ -18,6 +18,7 @@
 
 #include "board.h"
 #include <linux/spinlock.h>
+#include <linux/delay.h>
 
 static int check_for_eos( tms9914_private_t *priv, uint8_t byte )
 {
@@ -37,8 +38,31 @@ static int check_for_eos( tms9914_private_t *priv, uint8_t byte )
 	return 0;
 }
 
+/* Spins for up to board->pio_poll_usec before wait_for_read_byte() sleeps,
+ * since most bytes of a long response arrive within a few microseconds of
+ * the holdoff being released. */
+static int poll_for_read_byte(gpib_board_t *board, tms9914_private_t *priv)
+{
+	unsigned int i;
+
+	if(gpib_pseudo_irq_busy_poll(board) &&
+		(test_bit(READ_READY_BN, &priv->state) ||
+		test_bit(DEV_CLEAR_BN, &priv->state)))
+		return 1;
+	for(i = 0; i < board->pio_poll_usec; i++)
+	{
+		if(test_bit(READ_READY_BN, &priv->state) ||
+			test_bit(DEV_CLEAR_BN, &priv->state) ||
+			test_bit(TIMO_NUM, &board->status))
+			return 1;
+		udelay(1);
+	}
+	return 0;
+}
+
 static int wait_for_read_byte(gpib_board_t *board, tms9914_private_t *priv)
 {
+	poll_for_read_byte(board, priv);
 	if(wait_event_interruptible(board->wait,
 		test_bit(READ_READY_BN, &priv->state) ||
 		test_bit(DEV_CLEAR_BN, &priv->state) ||
@@ -184,8 +184,7 @@ int ni_pci_attach(gpib_board_t *board)
 		return -ENOMEM;
 	tnt_priv = board->private_data;
 	tms_priv = &tnt_priv->tms9914_priv;
-	tms_priv->read_byte = tms9914_iomem_read_byte;
-	tms_priv->write_byte = tms9914_iomem_write_byte;
+	tms_priv->io_method = TMS9914_IO_MEM;
 	tms_priv->offset = atgpib_reg_offset;
 
 	if(mite_devices == NULL)
@@ -55,6 +55,9 @@
 #include <linux/pci.h>
 #include <asm/io.h>
 #include <linux/slab.h>
+#include <linux/scatterlist.h>
+#include <linux/vmalloc.h>
+#include <linux/highmem.h>
 
 #include "mite.h"
 
@@ -144,6 +147,7 @@ void mite_cleanup(void)
 void mite_unsetup(struct mite_struct *mite)
 {
 	if(!mite)return;
+	mite_dma_free(mite);
 	if(mite->mite_io_addr)
 	{
 		iounmap(mite->mite_io_addr);
@@ -178,12 +182,165 @@ void mite_list_devices(void)
 
 }
 
+int mite_dma_alloc(struct mite_struct *mite)
+{
+	size_t ring_size = MITE_RING_SIZE * sizeof(struct mite_dma_chain);
+
+	mite->sg = kmalloc(MITE_RING_SIZE * sizeof(struct scatterlist), GFP_KERNEL);
+	if(mite->sg == NULL)
+		return -ENOMEM;
+	/* the tail word sits right after the ring, ring_size keeps it aligned */
+	mite->ring = pci_alloc_consistent(mite->pcidev, ring_size + sizeof(u32), &mite->ring_dma);
+	if(mite->ring == NULL)
+	{
+		kfree(mite->sg);
+		mite->sg = NULL;
+		return -ENOMEM;
+	}
+	mite->tail = (u8*)mite->ring + ring_size;
+	mite->tail_dma = mite->ring_dma + ring_size;
+	return 0;
+}
+
+void mite_dma_free(struct mite_struct *mite)
+{
+	size_t ring_size = MITE_RING_SIZE * sizeof(struct mite_dma_chain);
+
+	if(mite->ring)
+	{
+		pci_free_consistent(mite->pcidev, ring_size + sizeof(u32), mite->ring, mite->ring_dma);
+		mite->ring = NULL;
+		mite->tail = NULL;
+	}
+	kfree(mite->sg);
+	mite->sg = NULL;
+}
+
+static struct page *mite_buffer_page(unsigned long address)
+{
+	/* board->buffer is vmalloced, direct io buffers are vmapped user pages */
+	if(is_vmalloc_addr((void*)address))
+		return vmalloc_to_page((void*)address);
+	return virt_to_page(address);
+}
+
+/* Builds the link chain for a transfer between buffer and the device port.
+ * Each page of buffer gets its own scatterlist entry, so buffer need not be
+ * physically contiguous.  An odd last byte goes through mite->tail.  Returns
+ * how many bytes the chain covers, which is less than length if buffer spans
+ * more pages than the ring holds, or a negative errno if mapping failed. */
+ssize_t mite_dma_map(struct mite_struct *mite, uint8_t *buffer, size_t length, int dir)
+{
+	unsigned long address = (unsigned long)buffer;
+	size_t direct_length = length & ~1UL;
+	size_t mapped = 0;
+	struct scatterlist *sg;
+	int num_pages = 0;
+	int num_links;
+	int i;
+
+	if(length == 0)
+		return -EINVAL;
+	sg_init_table(mite->sg, MITE_RING_SIZE);
+	while(mapped < direct_length && num_pages < MITE_RING_SIZE - 1)
+	{
+		unsigned int offset = (address + mapped) & ~PAGE_MASK;
+		size_t segment = min_t(size_t, PAGE_SIZE - offset, direct_length - mapped);
+
+		sg_set_page(&mite->sg[num_pages++], mite_buffer_page(address + mapped), segment, offset);
+		mapped += segment;
+	}
+	if(num_pages)
+	{
+		/* pci_map_sg only looks after the pages' linear mapping, the
+		 * vmap alias we use may hold dirty lines on aliasing caches */
+		if(is_vmalloc_addr(buffer))
+			flush_kernel_vmap_range(buffer, mapped);
+		sg_mark_end(&mite->sg[num_pages - 1]);
+		num_links = pci_map_sg(mite->pcidev, mite->sg, num_pages, dir);
+		if(num_links == 0)
+			return -EIO;
+	}else
+		num_links = 0;
+	mite->sg_count = num_pages;
+	mite->dma_dir = dir;
+	mite->dma_direct_length = mapped;
+
+	for_each_sg(mite->sg, sg, num_links, i)
+	{
+		mite->ring[i].count = cpu_to_le32(sg_dma_len(sg));
+		mite->ring[i].addr = cpu_to_le32(sg_dma_address(sg));
+		mite->ring[i].next = cpu_to_le32(mite->ring_dma + (i + 1) * sizeof(struct mite_dma_chain));
+	}
+	if(mapped == direct_length && length > direct_length)
+	{
+		if(dir == PCI_DMA_TODEVICE)
+		{
+			mite->tail[0] = buffer[direct_length];
+			mite->tail[1] = 0;
+		}
+		mite->ring[num_links].count = cpu_to_le32(2);
+		mite->ring[num_links].addr = cpu_to_le32(mite->tail_dma);
+		++num_links;
+		mapped = length;
+	}
+	if(num_links == 0)
+		return -EINVAL;
+	mite->ring[num_links - 1].next = 0;
+	return mapped;
+}
+
+/* Releases the mapping made by mite_dma_map, and copies a byte received
+ * into mite->tail back to buffer. */
+void mite_dma_unmap(struct mite_struct *mite, uint8_t *buffer, size_t bytes_transferred)
+{
+	if(mite->sg_count)
+	{
+		pci_unmap_sg(mite->pcidev, mite->sg, mite->sg_count, mite->dma_dir);
+		/* drop anything stale the cpu cached through the vmap alias */
+		if(mite->dma_dir == PCI_DMA_FROMDEVICE && is_vmalloc_addr(buffer))
+			invalidate_kernel_vmap_range(buffer, mite->dma_direct_length);
+	}
+	mite->sg_count = 0;
+	if(mite->dma_dir == PCI_DMA_FROMDEVICE && bytes_transferred > mite->dma_direct_length)
+		buffer[mite->dma_direct_length] = mite->tail[0];
+}
+
+/* Starts channel 0 on the link chain built by mite_dma_map.  Device side
+ * cycles are 16 bit and paced by DRQ0, device address counts up from zero
+ * so MITE_DAR tracks the bytes moved through the device port. */
+void mite_dma_arm(struct mite_struct *mite)
+{
+	void *chan = mite->mite_io_addr + CHAN_OFFSET(0);
+	u32 chcr;
+
+	writel(CHOR_DMARESET | CHOR_FRESET, chan + MITE_CHOR);
+	chcr = CHCR_LINKSHORT | CHCR_BURSTEN;
+	if(mite->dma_dir == PCI_DMA_FROMDEVICE)
+		chcr |= CHCR_DEV_TO_MEM;
+	else
+		chcr |= CHCR_MEM_TO_DEV;
+	writel(chcr, chan + MITE_CHCR);
+	writel(CR_RL64 | CR_ASEQUP | CR_PSIZEWORD, chan + MITE_MCR);
+	writel(CR_ASEQUP | CR_PORTIO | CR_AMDEVICE | CR_REQSDRQ0 | CR_PSIZEHALF, chan + MITE_DCR);
+	writel(0, chan + MITE_DAR);
+	writel(CR_RL64 | CR_ASEQUP | CR_PSIZEWORD, chan + MITE_LKCR);
+	writel(mite->ring_dma, chan + MITE_LKAR);
+	writel(CHOR_START, chan + MITE_CHOR);
+}
+
+/* bytes sitting in the channel's fifo */
+int mite_fifo_count(struct mite_struct *mite, int chan)
+{
+	return readl(mite->mite_io_addr+MITE_FCR+CHAN_OFFSET(chan)) & 0x000000FF;
+}
+
 int mite_bytes_transferred(struct mite_struct *mite, int chan)
 {
 	int dar, fcr;
 
 	dar = readl(mite->mite_io_addr+MITE_DAR+CHAN_OFFSET(chan));
-	fcr = readl(mite->mite_io_addr+MITE_FCR+CHAN_OFFSET(chan)) & 0x000000FF;
+	fcr = mite_fifo_count(mite, chan);
 	return dar-fcr;
 }
 
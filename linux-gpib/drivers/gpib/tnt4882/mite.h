@@ -35,7 +35,9 @@
 #define MDPRINTK(format,args...)
 #endif
 
-#define MITE_RING_SIZE 3000
+/* one link chain entry per page, so this bounds a single dma transfer */
+#define MITE_RING_SIZE 512
+/* short link chain entry, fields are little endian */
 struct mite_dma_chain{
 	u32 count;
 	u32 addr;
@@ -54,7 +56,19 @@ struct mite_struct{
 
 	int DMA_CheckNearEnd;
 
-	struct mite_dma_chain ring[MITE_RING_SIZE];
+	/* link chain for channel 0, in coherent memory along with tail[] */
+	struct mite_dma_chain *ring;
+	dma_addr_t ring_dma;
+	/* bounce for the odd last byte of a transfer, the device port moves
+	 * 16 bit words */
+	u8 *tail;
+	dma_addr_t tail_dma;
+	struct scatterlist *sg;
+	int sg_count;
+	int dma_dir;
+	/* bytes of the mapped buffer which go straight to the buffer, rather
+	 * than through tail[] */
+	size_t dma_direct_length;
 };
 
 extern struct mite_struct *mite_devices;
@@ -74,13 +88,18 @@ int mite_setup(struct mite_struct *mite);
 void mite_unsetup(struct mite_struct *mite);
 void mite_list_devices(void);
 
+int mite_dma_alloc(struct mite_struct *mite);
+void mite_dma_free(struct mite_struct *mite);
+ssize_t mite_dma_map(struct mite_struct *mite, uint8_t *buffer, size_t length, int dir);
+void mite_dma_unmap(struct mite_struct *mite, uint8_t *buffer, size_t bytes_transferred);
+
 int mite_dma_tcr(struct mite_struct *mite);
 
 void mite_dma_arm(struct mite_struct *mite);
 void mite_dma_disarm(struct mite_struct *mite);
 
 void mite_dump_regs(struct mite_struct *mite);
-void mite_setregs(struct mite_struct *mite,unsigned long ll_start,int chan, int dir);
+int mite_fifo_count(struct mite_struct *mite, int chan);
 int mite_bytes_transferred(struct mite_struct *mite, int chan);
 
 #define CHAN_OFFSET(x)			(0x100*(x))
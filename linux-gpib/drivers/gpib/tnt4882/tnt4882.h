@@ -50,10 +50,6 @@ typedef struct
 	volatile unsigned short imr0_bits;
 	volatile unsigned short imr3_bits;
 	unsigned short auxg_bits;	// bits written to auxilliary register G
-	void (*io_writeb)(unsigned int value, void *address);
-	void (*io_writew)(unsigned int value, void *address);
-	unsigned int (*io_readb)(void *address);
-	unsigned int (*io_readw)(void *address);
 } tnt4882_private_t;
 
 // interfaces
@@ -109,6 +105,8 @@ int tnt4882_allocate_private(gpib_board_t *board);
 void tnt4882_free_private(gpib_board_t *board);
 void tnt4882_init( tnt4882_private_t *tnt_priv, const gpib_board_t *board );
 void tnt4882_board_reset( tnt4882_private_t *tnt_priv, gpib_board_t *board );
+size_t tnt4882_dma_map( tnt4882_private_t *tnt_priv, uint8_t *buffer, size_t length, int dir );
+void tnt4882_dma_enable( tnt4882_private_t *tnt_priv, int enable );
 
 // register offset for nec7210 compatible registers
 static const int atgpib_reg_offset = 2;
@@ -117,18 +115,59 @@ static const int atgpib_reg_offset = 2;
 static const int atgpib_iosize = 32;
 static const int pcmcia_gpib_iosize = 32;
 
+/* The tnt4882's own registers sit in the same window as its nec7210 ones,
+ * so nec7210_priv.io_method tells us whether to use port or memory io. */
+static inline int tnt_iomem( const tnt4882_private_t *priv )
+{
+	switch( priv->nec7210_priv.io_method )
+	{
+	case NEC7210_IO_MEM:
+	case NEC7210_IO_LOCKING_MEM:
+		return 1;
+	default:
+		break;
+	}
+	return 0;
+}
+static inline unsigned int tnt_io_readb( const tnt4882_private_t *priv, void *address )
+{
+	if( tnt_iomem( priv ) )
+		return readb( address );
+	return inb( ( unsigned long ) address );
+}
+static inline void tnt_io_writeb( const tnt4882_private_t *priv, unsigned int value, void *address )
+{
+	if( tnt_iomem( priv ) )
+		writeb( value, address );
+	else
+		outb( value, ( unsigned long ) address );
+}
+static inline unsigned int tnt_io_readw( const tnt4882_private_t *priv, void *address )
+{
+	if( tnt_iomem( priv ) )
+		return readw( address );
+	return inw( ( unsigned long ) address );
+}
+static inline void tnt_io_writew( const tnt4882_private_t *priv, unsigned int value, void *address )
+{
+	if( tnt_iomem( priv ) )
+		writew( value, address );
+	else
+		outw( value, ( unsigned long ) address );
+}
+
 /* paged io */
 static inline unsigned int tnt_paged_readb( tnt4882_private_t *priv, unsigned long offset )
 {
-	priv->io_writeb(AUX_PAGEIN, priv->nec7210_priv.iobase + AUXMR * priv->nec7210_priv.offset);
+	tnt_io_writeb(priv, AUX_PAGEIN, priv->nec7210_priv.iobase + AUXMR * priv->nec7210_priv.offset);
 	udelay(1);
-	return priv->io_readb(priv->nec7210_priv.iobase + offset);
+	return tnt_io_readb(priv, priv->nec7210_priv.iobase + offset);
 }
 static inline void tnt_paged_writeb(tnt4882_private_t *priv, unsigned int value, unsigned long offset )
 {
-	priv->io_writeb(AUX_PAGEIN, priv->nec7210_priv.iobase + AUXMR * priv->nec7210_priv.offset);
+	tnt_io_writeb(priv, AUX_PAGEIN, priv->nec7210_priv.iobase + AUXMR * priv->nec7210_priv.offset);
 	udelay(1);
-	priv->io_writeb(value, priv->nec7210_priv.iobase + offset);
+	tnt_io_writeb(priv, value, priv->nec7210_priv.iobase + offset);
 }
 
 /* readb/writeb wrappers */
@@ -149,7 +188,7 @@ static inline unsigned short tnt_readb( tnt4882_private_t *priv, unsigned long o
 		switch(priv->nec7210_priv.type)
 		{
 		case TNT4882:
-			retval = priv->io_readb(address);
+			retval = tnt_io_readb(priv, address);
 			break;
 		case NAT4882:
 			retval = tnt_paged_readb( priv, offset - tnt_pagein_offset );
@@ -164,7 +203,7 @@ static inline unsigned short tnt_readb( tnt4882_private_t *priv, unsigned long o
 		}
 		break;
 	default:
-		retval = priv->io_readb( address );
+		retval = tnt_io_readb( priv, address );
 		break;
 	}
 	spin_unlock_irqrestore( register_lock, flags );
@@ -186,7 +225,7 @@ static inline void tnt_writeb( tnt4882_private_t *priv, unsigned short value, un
 		switch(priv->nec7210_priv.type)
 		{
 		case TNT4882:
-			priv->io_writeb( value, address );
+			tnt_io_writeb( priv, value, address );
 			break;
 		case NAT4882:
 			tnt_paged_writeb( priv, value, offset - tnt_pagein_offset );
@@ -199,7 +238,7 @@ static inline void tnt_writeb( tnt4882_private_t *priv, unsigned short value, un
 		}
 		break;
 	default:
-		priv->io_writeb( value, address );
+		tnt_io_writeb( priv, value, address );
 		break;
 	}
 	spin_unlock_irqrestore( register_lock, flags );
@@ -304,6 +304,7 @@ gpib_interface_t ni_pcmcia_interface =
 	serial_poll_status: tnt4882_serial_poll_status,
 	t1_delay: tnt4882_t1_delay,
 	return_to_local: tnt4882_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t ni_pcmcia_accel_interface =
@@ -332,6 +333,7 @@ gpib_interface_t ni_pcmcia_accel_interface =
 	serial_poll_status: tnt4882_serial_poll_status,
 	t1_delay: tnt4882_t1_delay,
 	return_to_local: tnt4882_return_to_local,
+	direct_io: 1,
 };
 
 int ni_pcmcia_attach(gpib_board_t *board, gpib_board_config_t config)
@@ -357,14 +359,9 @@ int ni_pcmcia_attach(gpib_board_t *board, gpib_board_config_t config)
 	if(tnt4882_allocate_private(board))
 		return -ENOMEM;
 	tnt_priv = board->private_data;
-	tnt_priv->io_writeb = outb_wrapper;
-	tnt_priv->io_readb = inb_wrapper;
-	tnt_priv->io_writew = outw_wrapper;
-	tnt_priv->io_readw = inw_wrapper;
 	nec_priv = &tnt_priv->nec7210_priv;
 	nec_priv->type = TNT4882;
-	nec_priv->read_byte = nec7210_locking_ioport_read_byte;
-	nec_priv->write_byte = nec7210_locking_ioport_write_byte;
+	nec_priv->io_method = NEC7210_IO_LOCKING_PORT;
 	nec_priv->offset = atgpib_reg_offset;
 
 	DEBUG(0, "ioport1 window attributes: 0x%lx\n", curr_dev->resource[0]->flags );
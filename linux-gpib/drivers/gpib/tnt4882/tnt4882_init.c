@@ -199,6 +199,7 @@ gpib_interface_t ni_pci_interface =
 	serial_poll_status: tnt4882_serial_poll_status,
 	t1_delay: tnt4882_t1_delay,
 	return_to_local: tnt4882_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t ni_pci_accel_interface =
@@ -227,6 +228,7 @@ gpib_interface_t ni_pci_accel_interface =
 	serial_poll_status: tnt4882_serial_poll_status,
 	t1_delay: tnt4882_t1_delay,
 	return_to_local: tnt4882_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t ni_isa_interface =
@@ -255,6 +257,7 @@ gpib_interface_t ni_isa_interface =
 	serial_poll_status: tnt4882_serial_poll_status,
 	t1_delay: tnt4882_t1_delay,
 	return_to_local: tnt4882_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t ni_nat4882_isa_interface =
@@ -339,6 +342,7 @@ gpib_interface_t ni_isa_accel_interface =
 	serial_poll_status: tnt4882_serial_poll_status,
 	t1_delay: tnt4882_t1_delay,
 	return_to_local: tnt4882_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t ni_nat4882_isa_accel_interface =
@@ -367,6 +371,7 @@ gpib_interface_t ni_nat4882_isa_accel_interface =
 	serial_poll_status: tnt4882_serial_poll_status,
 	t1_delay: tnt4882_t1_delay,
 	return_to_local: tnt4882_return_to_local,
+	direct_io: 1,
 };
 
 gpib_interface_t ni_nec_isa_accel_interface =
@@ -395,6 +400,7 @@ gpib_interface_t ni_nec_isa_accel_interface =
 	serial_poll_status: tnt4882_serial_poll_status,
 	t1_delay: tnt4882_t1_delay,
 	return_to_local: tnt4882_return_to_local,
+	direct_io: 1,
 };
 
 void tnt4882_board_reset( tnt4882_private_t *tnt_priv, gpib_board_t *board )
@@ -410,6 +416,42 @@ void tnt4882_board_reset( tnt4882_private_t *tnt_priv, gpib_board_t *board )
 	nec7210_board_reset( nec_priv, board );
 }
 
+/* Reads and writes shorter than this go through the fifo with the cpu, since
+ * setting up the mite costs more than it saves.  Off by default until the
+ * dma request wiring has been checked on real boards. */
+static unsigned int dma_threshold = 0;
+module_param(dma_threshold, uint, 0644);
+MODULE_PARM_DESC(dma_threshold, "shortest read or write pci boards do with mite dma, 0 (the default) disables dma");
+
+/* Maps buffer for a mite dma transfer if the board and transfer are suitable.
+ * Returns the number of bytes mapped, or 0 if the transfer should use the
+ * fifo with the cpu instead. */
+size_t tnt4882_dma_map( tnt4882_private_t *tnt_priv, uint8_t *buffer, size_t length, int dir )
+{
+	struct mite_struct *mite = tnt_priv->mite;
+	ssize_t mapped;
+
+	if( mite == NULL || mite->ring == NULL || dma_threshold == 0 ||
+		length < dma_threshold )
+		return 0;
+	/* memory side of the mite does 32 bit cycles */
+	if( ( unsigned long ) buffer & 0x3 )
+		return 0;
+	mapped = mite_dma_map( mite, buffer, length, dir );
+	if( mapped < 0 )
+		return 0;
+	return mapped;
+}
+
+/* lets the tnt4882 fifo pace the mite through its dma request line */
+void tnt4882_dma_enable( tnt4882_private_t *tnt_priv, int enable )
+{
+	if( enable )
+		tnt_writeb( tnt_priv, TNT_ONE_CHIP_BIT, HSSEL );
+	else
+		tnt_writeb( tnt_priv, NODMA | TNT_ONE_CHIP_BIT, HSSEL );
+}
+
 int tnt4882_allocate_private(gpib_board_t *board)
 {
 	tnt4882_private_t *tnt_priv;
@@ -492,14 +534,9 @@ int ni_pci_attach(gpib_board_t *board, gpib_board_config_t config)
 	if(tnt4882_allocate_private(board))
 		return -ENOMEM;
 	tnt_priv = board->private_data;
-	tnt_priv->io_writeb = writeb_wrapper;
-	tnt_priv->io_readb = readb_wrapper;
-	tnt_priv->io_writew = writew_wrapper;
-	tnt_priv->io_readw = readw_wrapper;
 	nec_priv = &tnt_priv->nec7210_priv;
 	nec_priv->type = TNT4882;
-	nec_priv->read_byte = nec7210_locking_iomem_read_byte;
-	nec_priv->write_byte = nec7210_locking_iomem_write_byte;
+	nec_priv->io_method = NEC7210_IO_LOCKING_MEM;
 	nec_priv->offset = atgpib_reg_offset;
 
 	if(mite_devices == NULL)
@@ -559,6 +596,8 @@ int ni_pci_attach(gpib_board_t *board, gpib_board_config_t config)
 	}
 	tnt_priv->irq = mite_irq(tnt_priv->mite);
 	printk( "tnt4882: irq %i\n", tnt_priv->irq );
+	if( mite_dma_alloc( tnt_priv->mite ) )
+		printk( "tnt4882: failed to allocate mite dma chain, using fifo io only\n" );
 
 	tnt4882_init( tnt_priv, board );
 
@@ -631,14 +670,9 @@ int ni_isa_attach_common( gpib_board_t *board, enum nec7210_chipset chipset )
 	if(tnt4882_allocate_private(board))
 		return -ENOMEM;
 	tnt_priv = board->private_data;
-	tnt_priv->io_writeb = outb_wrapper;
-	tnt_priv->io_readb = inb_wrapper;
-	tnt_priv->io_writew = outw_wrapper;
-	tnt_priv->io_readw = inw_wrapper;
 	nec_priv = &tnt_priv->nec7210_priv;
 	nec_priv->type = chipset;
-	nec_priv->read_byte = nec7210_locking_ioport_read_byte;
-	nec_priv->write_byte = nec7210_locking_ioport_write_byte;
+	nec_priv->io_method = NEC7210_IO_LOCKING_PORT;
 	nec_priv->offset = atgpib_reg_offset;
 
 	// look for plug-n-play board
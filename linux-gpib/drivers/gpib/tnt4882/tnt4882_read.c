@@ -60,7 +60,7 @@ static int drain_fifo_words(tnt4882_private_t *tnt_priv, uint8_t *buffer, int nu
 	{
 		short word;
 
-		word = tnt_priv->io_readw( nec_priv->iobase + FIFOB );
+		word = tnt_io_readw( tnt_priv, nec_priv->iobase + FIFOB );
 		buffer[ count++ ] = word & 0xff;
 		buffer[ count++ ] = ( word >> 8 ) & 0xff;
 	}
@@ -92,6 +92,70 @@ static void tnt4882_release_holdoff(gpib_board_t *board, tnt4882_private_t *tnt_
 	}
 }
 
+// waits for the hardware counter to finish, or the read to end early
+static int read_done_wait( gpib_board_t *board, tnt4882_private_t *tnt_priv,
+	unsigned int imr3_bits )
+{
+	nec7210_private_t *nec_priv = &tnt_priv->nec7210_priv;
+	unsigned long flags;
+	int retval = 0;
+
+	spin_lock_irqsave( &board->spinlock, flags );
+	tnt_priv->imr3_bits |= imr3_bits;
+	tnt_writeb( tnt_priv, tnt_priv->imr3_bits, IMR3 );
+	spin_unlock_irqrestore( &board->spinlock, flags );
+
+	if( wait_event_interruptible( board->wait,
+		fifo_xfer_done( tnt_priv ) ||
+		test_bit( RECEIVED_END_BN, &nec_priv->state ) ||
+		test_bit( DEV_CLEAR_BN, &nec_priv->state ) ||
+		test_bit( TIMO_NUM, &board->status ) ) )
+	{
+		printk("tnt4882: read interrupted\n");
+		retval = -ERESTARTSYS;
+	}
+	if( test_bit( TIMO_NUM, &board->status ) )
+	{
+		printk("tnt4882: read timed out\n");
+		retval = -ETIMEDOUT;
+	}
+	if( test_bit( DEV_CLEAR_BN, &nec_priv->state ) )
+	{
+		printk("tnt4882: device clear interrupted read\n");
+		retval = -EINTR;
+	}
+	return retval;
+}
+
+/* Stops a mite dma read once the tnt4882 is done, and returns how many
+ * bytes reached the buffer.  Anything the mite didn't pick up from the
+ * fifo (an odd last byte, for instance) is drained with the cpu. */
+static size_t dma_read_finish( tnt4882_private_t *tnt_priv, uint8_t *buffer, size_t length )
+{
+	struct mite_struct *mite = tnt_priv->mite;
+	size_t count;
+	int i;
+
+	// give the mite a moment to empty both fifos into memory
+	for( i = 0; i < 100; i++ )
+	{
+		if( fifo_word_available( tnt_priv ) == 0 && mite_fifo_count( mite, 0 ) == 0 )
+			break;
+		udelay(1);
+	}
+	mite_dma_disarm( mite );
+	tnt4882_dma_enable( tnt_priv, 0 );
+	count = mite_bytes_transferred( mite, 0 );
+	if( count > length )
+		count = length;
+	mite_dma_unmap( mite, buffer, count );
+
+	count += drain_fifo_words( tnt_priv, &buffer[ count ], length - count );
+	if( fifo_byte_available( tnt_priv ) && count < length )
+		buffer[ count++ ] = tnt_readb( tnt_priv, FIFOB );
+	return count;
+}
+
 int tnt4882_accel_read( gpib_board_t *board, uint8_t *buffer, size_t length, int *end, size_t *bytes_read)
 {
 	size_t count = 0;
@@ -101,8 +165,13 @@ int tnt4882_accel_read( gpib_board_t *board, uint8_t *buffer, size_t length, int
 	unsigned int bits, imr0_bits, imr1_bits, imr2_bits;
 	int32_t hw_count;
 	unsigned long flags;
+	size_t dma_length;
 
 	*bytes_read = 0;
+	// a read bigger than the mite's chain just stops short, caller reads again
+	dma_length = tnt4882_dma_map( tnt_priv, buffer, length, PCI_DMA_FROMDEVICE );
+	if( dma_length )
+		length = dma_length;
 	// FIXME: really, DEV_CLEAR_BN should happen elsewhere to prevent race
 	clear_bit(DEV_CLEAR_BN, &nec_priv->state);	
 	imr1_bits = nec_priv->reg_bits[ IMR1 ];
@@ -127,17 +196,30 @@ int tnt4882_accel_read( gpib_board_t *board, uint8_t *buffer, size_t length, int
 	tnt_writeb( tnt_priv, ( hw_count >> 16 ) & 0xff, CNT2 );
 	tnt_writeb( tnt_priv, ( hw_count >> 24 ) & 0xff, CNT3 );
 
+	if( dma_length )
+	{
+		mite_dma_arm( tnt_priv->mite );
+		tnt4882_dma_enable( tnt_priv, 1 );
+	}
+
 	tnt4882_release_holdoff(board, tnt_priv);
 
 	tnt_writeb( tnt_priv, GO, CMDR );
 	udelay(1);
 
-	spin_lock_irqsave( &board->spinlock, flags );
-	tnt_priv->imr3_bits |= HR_DONE | HR_NEF;
-	tnt_writeb( tnt_priv, tnt_priv->imr3_bits, IMR3 );
-	spin_unlock_irqrestore( &board->spinlock, flags );
-
-	while(count + 2 <= length &&
+	if( dma_length )
+	{
+		// the mite moves the data, we only wait for the end
+		retval = read_done_wait( board, tnt_priv, HR_DONE );
+		count = dma_read_finish( tnt_priv, buffer, length );
+	}else
+	{
+		spin_lock_irqsave( &board->spinlock, flags );
+		tnt_priv->imr3_bits |= HR_DONE | HR_NEF;
+		tnt_writeb( tnt_priv, tnt_priv->imr3_bits, IMR3 );
+		spin_unlock_irqrestore( &board->spinlock, flags );
+	}
+	while(dma_length == 0 && count + 2 <= length &&
 		test_bit( RECEIVED_END_BN, &nec_priv->state ) == 0 &&
 		fifo_xfer_done(tnt_priv) == 0)
 	{
@@ -176,32 +258,9 @@ int tnt4882_accel_read( gpib_board_t *board, uint8_t *buffer, size_t length, int
 			schedule();
 	}
 	// wait for last byte
-	if( count < length )
+	if( dma_length == 0 && count < length )
 	{
-		spin_lock_irqsave( &board->spinlock, flags );
-		tnt_priv->imr3_bits |= HR_DONE | HR_NEF;
-		tnt_writeb( tnt_priv, tnt_priv->imr3_bits, IMR3 );
-		spin_unlock_irqrestore( &board->spinlock, flags );
-
-		if( wait_event_interruptible( board->wait,
-			fifo_xfer_done( tnt_priv ) ||
-			test_bit( RECEIVED_END_BN, &nec_priv->state ) ||
-			test_bit( DEV_CLEAR_BN, &nec_priv->state ) ||
-			test_bit( TIMO_NUM, &board->status ) ) )
-		{
-			printk("tnt4882: read interrupted\n");
-			retval = -ERESTARTSYS;
-		}
-		if( test_bit( TIMO_NUM, &board->status ) )
-		{
-			printk("tnt4882: read timed out\n");
-			retval = -ETIMEDOUT;
-		}
-		if( test_bit( DEV_CLEAR_BN, &nec_priv->state ) )
-		{
-			printk("tnt4882: device clear interrupted read\n");
-			retval = -EINTR;
-		}
+		retval = read_done_wait( board, tnt_priv, HR_DONE | HR_NEF );
 		count += drain_fifo_words(tnt_priv, &buffer[count], length - count);
 		if(fifo_byte_available( tnt_priv ) && count < length)
 		{
@@ -94,8 +94,17 @@ static int generic_write( gpib_board_t *board, uint8_t *buffer, size_t length,
 	unsigned int bits, imr0_bits, imr1_bits, imr2_bits;
 	int32_t hw_count;
 	unsigned long flags;
+	size_t dma_length = 0;
 
 	*bytes_written = 0;
+	if( send_commands == 0 )
+		dma_length = tnt4882_dma_map( tnt_priv, buffer, length, PCI_DMA_TODEVICE );
+	if( dma_length && dma_length < length )
+	{
+		// more pages than the mite's chain holds, caller writes the rest
+		length = dma_length;
+		send_eoi = 0;
+	}
 	// FIXME: really, DEV_CLEAR_BN should happen elsewhere to prevent race
 	clear_bit(DEV_CLEAR_BN, &nec_priv->state);	
 	imr1_bits = nec_priv->reg_bits[ IMR1 ];
@@ -130,6 +139,12 @@ static int generic_write( gpib_board_t *board, uint8_t *buffer, size_t length,
 	tnt_writeb( tnt_priv, ( hw_count >> 16 ) & 0xff, CNT2 );
 	tnt_writeb( tnt_priv, ( hw_count >> 24 ) & 0xff, CNT3 );
 
+	if( dma_length )
+	{
+		mite_dma_arm( tnt_priv->mite );
+		tnt4882_dma_enable( tnt_priv, 1 );
+	}
+
 	tnt_writeb( tnt_priv, GO, CMDR );
 	udelay(1);
 
@@ -138,7 +153,8 @@ static int generic_write( gpib_board_t *board, uint8_t *buffer, size_t length,
 	tnt_writeb( tnt_priv, tnt_priv->imr3_bits, IMR3 );
 	spin_unlock_irqrestore( &board->spinlock, flags );
 
-	while( count < length  )
+	// the mite keeps the fifo full, we only wait for the last byte below
+	while( dma_length == 0 && count < length  )
 	{
 		// wait until byte is ready to be sent
 		retval = write_wait( board, tnt_priv, 0 );
@@ -153,7 +169,7 @@ static int generic_write( gpib_board_t *board, uint8_t *buffer, size_t length,
 			word = buffer[ count++ ] & 0xff;
 			if( count < length )
 				word |= ( buffer[ count++ ] << 8 ) & 0xff00;
-			tnt_priv->io_writew( word, nec_priv->iobase + FIFOB );
+			tnt_io_writew( tnt_priv, word, nec_priv->iobase + FIFOB );
 		}
 		tnt_priv->imr3_bits |= HR_NFF;
 		tnt_writeb( tnt_priv, tnt_priv->imr3_bits, IMR3 );
@@ -168,6 +184,12 @@ static int generic_write( gpib_board_t *board, uint8_t *buffer, size_t length,
 
 	tnt_writeb( tnt_priv, STOP, CMDR );
 	udelay(1);
+	if( dma_length )
+	{
+		mite_dma_disarm( tnt_priv->mite );
+		tnt4882_dma_enable( tnt_priv, 0 );
+		mite_dma_unmap( tnt_priv->mite, buffer, 0 );
+	}
 
 	nec7210_set_reg_bits( nec_priv, IMR1, 0xff, imr1_bits );
 	nec7210_set_reg_bits( nec_priv, IMR2, 0xff, imr2_bits );
@@ -18,60 +18,56 @@
 #include "ib_internal.h"
 #include <sys/ioctl.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 
-static void* do_aio( void *varg );
-
-struct gpib_aio_arg
-{
-	int ud;
-	ibConf_t *conf;
-	int gpib_aio_type;
-	int condition_flag;
-};
-
 void init_async_op( struct async_operation *async )
 {
 	pthread_mutex_init( &async->lock, NULL );
-	pthread_mutex_init( &async->join_lock, NULL );
-	pthread_cond_init(&async->condition, NULL);
-	async->buffer = NULL;
-	async->buffer_length = 0;
 	async->iberr = 0;
 	async->ibsta = 0;
 	async->ibcntl = 0;
 	async->in_progress = 0;
-	async->abort = 0;
-}
-
-static void cleanup_aio( void *varg )
-{
-	struct gpib_aio_arg arg = *((struct gpib_aio_arg*) varg);
-	ibBoard_t *board = interfaceBoard(arg.conf);
-	ibstatus( arg.conf, 0, 0, CMPL);
-	int retval = unlock_board_mutex(board);
-	assert(retval == 0);
 }
 
+/* Starts an asynchronous transfer.  The driver does the transfer in the
+ * background and clears CMPL until it is done, so ibwait() on CMPL (or
+ * poll() on a descriptor from ibpollfd()) works without a helper thread. */
 int gpib_aio_launch( int ud, ibConf_t *conf, int gpib_aio_type,
 	void *buffer, long cnt )
 {
+	ibBoard_t *board;
+	xfer_ioctl_t cmd;
+	Addr4882_t address;
 	int retval;
-	struct gpib_aio_arg *arg;
-	pthread_attr_t attributes;
 
-	arg = malloc( sizeof( *arg ) );
-	if( arg == NULL )
+	board = interfaceBoard( conf );
+
+	if( conf->is_interface || gpib_aio_type == GPIB_AIO_COMMAND )
+		address = NOADDR;
+	else
+		address = packAddress( conf->settings.pad, conf->settings.sad );
+
+	switch( gpib_aio_type )
 	{
+	case GPIB_AIO_COMMAND:
+		init_xfer_cmd( conf, &cmd, address, 1, buffer, cnt, 0, 0, 0 );
+		cmd.command = 1;
+		break;
+	case GPIB_AIO_READ:
+		init_xfer_cmd( conf, &cmd, address, 0, buffer, cnt, conf->settings.eos,
+			conf->settings.eos_flags, 0 );
+		break;
+	case GPIB_AIO_WRITE:
+		init_xfer_cmd( conf, &cmd, address, 1, buffer, cnt, 0, 0,
+			conf->settings.send_eoi );
+		break;
+	default:
+		fprintf( stderr, "libgpib: bug! in %s\n", __FUNCTION__ );
 		setIberr( EDVR );
-		setIbcnt( ENOMEM );
 		return -1;
 	}
-	arg->ud = ud;
-	arg->conf = conf;
-	arg->gpib_aio_type = gpib_aio_type;
-	arg->condition_flag = 0;
-	
+
 	pthread_mutex_lock( &conf->async.lock );
 	if( conf->async.in_progress )
 	{
@@ -82,120 +78,60 @@ int gpib_aio_launch( int ud, ibConf_t *conf, int gpib_aio_type,
 	conf->async.ibsta = 0;
 	conf->async.ibcntl = 0;
 	conf->async.iberr = 0;
-	conf->async.buffer = buffer;
-	conf->async.buffer_length = cnt;
-	conf->async.abort = 0;
-
-	pthread_attr_init( &attributes );
-	pthread_attr_setstacksize( &attributes, 0x10000 );
-	retval = pthread_create( &conf->async.thread,
-		&attributes, do_aio, arg );
-	pthread_attr_destroy( &attributes );
-	conf->async.in_progress = (retval == 0);
-	while(arg->condition_flag == 0)
-	{
-		pthread_cond_wait(&conf->async.condition, &conf->async.lock);
-	}
-	pthread_mutex_unlock( &conf->async.lock );
-	free( arg ); arg = NULL;
-	if( retval )
+
+	retval = ioctl( board->fileno, IBAIO_START, &cmd );
+	if( retval < 0 )
 	{
+		pthread_mutex_unlock( &conf->async.lock );
 		setIberr( EDVR );
-		setIbcnt( retval );
+		setIbcnt( errno );
 		return -1;
 	}
+	conf->async.in_progress = 1;
+	pthread_mutex_unlock( &conf->async.lock );
 
 	return 0;
 }
 
-static void* do_aio( void *varg )
+/* Waits for the asynchronous transfer to finish, and stores its results
+ * in conf->async.  Does nothing if the results were already collected. */
+int gpib_aio_complete( ibConf_t *conf )
 {
-	size_t count;
-	struct gpib_aio_arg * const arg_p = (struct gpib_aio_arg*) varg;
-	struct gpib_aio_arg arg;
-	ibConf_t *conf;
 	ibBoard_t *board;
+	xfer_ioctl_t cmd;
 	int retval;
 
-	arg = *arg_p;
+	board = interfaceBoard( conf );
 
-	conf = arg.conf;
-	board = interfaceBoard(conf);
-	retval = lock_board_mutex(board);
-	if(retval == 0)
+	memset( &cmd, 0, sizeof( cmd ) );
+	cmd.handle = conf->handle;
+	retval = ioctl( board->fileno, IBAIO_COMPLETE, &cmd );
+	if( retval < 0 && errno == ESRCH )
+		return 0;
+	/* interrupted by a signal, the transfer is still going */
+	if( retval < 0 && errno == EINTR )
 	{
-		ibstatus(conf, 0, CMPL, 0);
-	}
-	pthread_mutex_lock(&conf->async.lock);
-	arg_p->condition_flag = 1;
-	pthread_cond_broadcast(&conf->async.condition);
-	pthread_mutex_unlock(&conf->async.lock);
-	// don't use arg_p after this point, it may be
-	// deallocated by the thread which launched this one.
-	
-	if( retval < 0 ) return NULL;
-
-	pthread_cleanup_push( cleanup_aio, &arg );
-	pthread_setcanceltype( PTHREAD_CANCEL_ASYNCHRONOUS, NULL );
-	pthread_setcancelstate( PTHREAD_CANCEL_ENABLE, NULL );
-
-	switch( arg.gpib_aio_type )
-	{
-	case GPIB_AIO_COMMAND:
-		count = retval = my_ibcmd( conf, conf->async.buffer, conf->async.buffer_length );
-		break;
-	case GPIB_AIO_READ:
-		retval = my_ibrd( conf, conf->async.buffer, conf->async.buffer_length, &count);
-		break;
-	case GPIB_AIO_WRITE:
-		retval = my_ibwrt(conf, conf->async.buffer, conf->async.buffer_length, &count);
-		break;
-	default:
-		retval = -1;
-		fprintf( stderr, "libgpib: bug! in %s\n", __FUNCTION__ );
-		break;
+		setIberr( EABO );
+		return -1;
 	}
-	pthread_setcancelstate( PTHREAD_CANCEL_DISABLE, NULL );
+
 	pthread_mutex_lock( &conf->async.lock );
-	if(retval < 0)
+	finish_xfer( conf, &cmd, retval );
+	if( retval < 0 )
 	{
-		if(ThreadIberr() != EDVR)
-			conf->async.ibcntl = count;
+		if( ThreadIberr() != EDVR )
+			conf->async.ibcntl = cmd.completed_transfer_count;
 		else
 			conf->async.ibcntl = ThreadIbcntl();
 		conf->async.iberr = ThreadIberr();
 		conf->async.ibsta = CMPL | ERR;
 	}else
 	{
-		conf->async.ibcntl = count;
+		conf->async.ibcntl = cmd.completed_transfer_count;
 		conf->async.iberr = 0;
 		conf->async.ibsta = CMPL;
 	}
 	pthread_mutex_unlock( &conf->async.lock );
-	pthread_cleanup_pop( 1 );
-	return NULL;
-}
-
-int gpib_aio_join( struct async_operation *async )
-{
-	int retval;
 
-	pthread_mutex_lock( &async->join_lock );
-	retval = pthread_join( async->thread, NULL );
-	switch( retval )
-	{
-	case 0:
-		break;
-	case ESRCH:	/* thread has already been joined */
-		retval = 0;
-		break;
-	default:
-		fprintf( stderr, "libgpib: pthread_join() returned %i in %s\n",
-			retval, __FUNCTION__ );
-		setIberr( EDVR );
-		setIbcnt( retval );
-		break;
-	}
-	pthread_mutex_unlock( &async->join_lock );
-	return retval;
+	return 0;
 }
@@ -45,6 +45,12 @@ typedef struct
 	int assert_remote_enable;
 	int offline;
 	int is_system_controller;
+	unsigned int buffer_length;
+	unsigned int max_buffer_length;
+	int poll_min_period;
+	int poll_max_period;
+	int busy_poll;
+	int pio_poll;
 	void *init_data;
 	int init_data_length;
 } parsed_options_t;
@@ -54,6 +60,11 @@ static void help( void )
 	printf("gpib_config [options] - configures a GPIB interface board\n");
 	printf("\t-t, --board-type BOARD_TYPE\n"
 		"\t\tSet board type to BOARD_TYPE.\n");
+	printf("\t-B, --buffer-size NUM\n"
+		"\t\tSet length of the driver's transfer buffer to NUM bytes.\n");
+	printf("\t--busy-poll NUM\n"
+		"\t\tFor boards polled because they have no irq, let a read spin for up to\n"
+		"\t\tNUM microseconds polling for a byte handshake before it sleeps.\n");
 	printf("\t-c, --device-file FILEPATH\n"
 		"\t\tSpecify character device file path for the board.\n"
 		"\t\tThis can be used as an alternative to the --minor option.\n");
@@ -71,6 +82,9 @@ static void help( void )
 		"\t\tfile is /etc/gpib.conf\n");
 	printf("\t-h, --help\n"
 		"\t\tPrint this help and exit.\n");
+	printf("\t-M, --max-buffer-size NUM\n"
+		"\t\tAllow the driver's transfer buffer to grow up to NUM bytes when\n"
+		"\t\tit sees sustained large transfers.\n");
 	printf("\t-m, --minor NUM\n"
 		"\t\tConfigure gpib device file with minor number NUM (default 0).\n"
 		"\t\tAlternatively, the device file may be specified with the --device-file option.\n");
@@ -80,8 +94,17 @@ static void help( void )
 		"\t\tAssert (or not) remote enable line after bringing board online.  Default is --sre.\n");
 	printf("\t--[no-]system-controller\n"
 		"\t\tConfigure board as system controller (or not).\n");
+	printf("\t--poll-max-period NUM\n"
+		"\t\tFor boards polled because they have no irq, poll at least every NUM\n"
+		"\t\tmicroseconds while the bus is idle.\n");
+	printf("\t--poll-min-period NUM\n"
+		"\t\tFor boards polled because they have no irq, poll every NUM microseconds\n"
+		"\t\tduring a transfer.\n");
 	printf("\t-o, --offline\n"
 		"\t\tDon't bring board online.\n");
+	printf("\t--pio-poll NUM\n"
+		"\t\tLet byte at a time reads spin for up to NUM microseconds waiting for\n"
+		"\t\teach byte before sleeping.  0 always sleeps.\n");
 	printf("\t-p, --pad NUM\n"
 		"\t\tSpecify primary gpib address.  NUM should be in the range 0 through 30.\n");
 	printf("\t-u, --pci-bus NUM\n"
@@ -141,6 +164,15 @@ static int load_init_data(parsed_options_t *settings, const char *file_path)
 	fclose(init_file);
 	return retval;
 }
+/* options which have no short form */
+enum long_only_options
+{
+	busy_poll_option = 0x100,
+	poll_max_period_option,
+	poll_min_period_option,
+	pio_poll_option,
+};
+
 static int parse_options( int argc, char *argv[], parsed_options_t *settings )
 {
 	int c, index;
@@ -149,6 +181,7 @@ static int parse_options( int argc, char *argv[], parsed_options_t *settings )
 	struct option options[] =
 	{
 		{ "iobase", required_argument, NULL, 'b' },
+		{ "buffer-size", required_argument, NULL, 'B' },
 		{ "device-file", required_argument, NULL, 'c' },
 		{ "dma", required_argument, NULL, 'd' },
 		{ "file", required_argument, NULL, 'f' },
@@ -157,11 +190,16 @@ static int parse_options( int argc, char *argv[], parsed_options_t *settings )
 		{ "irq", required_argument, NULL, 'i' },
 		{ "pci-slot", required_argument, NULL, 'l' },
 		{ "minor", required_argument, NULL, 'm' },
+		{ "max-buffer-size", required_argument, NULL, 'M' },
 		{ "offline", no_argument, NULL, 'o' },
 		{ "pad", required_argument, NULL, 'p' },
 		{ "sad", required_argument, NULL, 's' },
 		{ "board-type", required_argument, NULL, 't' },
 		{ "pci-bus", required_argument, NULL, 'u' },
+		{ "poll-max-period", required_argument, NULL, poll_max_period_option },
+		{ "poll-min-period", required_argument, NULL, poll_min_period_option },
+		{ "busy-poll", required_argument, NULL, busy_poll_option },
+		{ "pio-poll", required_argument, NULL, pio_poll_option },
 		{ "version", no_argument, NULL, 'v' },
 		{ "no-ifc", no_argument, &settings->assert_ifc, 0 },
 		{ "ifc", no_argument, &settings->assert_ifc, 1 },
@@ -180,13 +218,17 @@ static int parse_options( int argc, char *argv[], parsed_options_t *settings )
 	settings->pci_slot = -1;
 	settings->pad = -1;
 	settings->sad = -1;
+	settings->poll_min_period = -1;
+	settings->poll_max_period = -1;
+	settings->busy_poll = -1;
+	settings->pio_poll = -1;
 	settings->assert_ifc = 1;
 	settings->assert_remote_enable = 1;
 	settings->is_system_controller = -1;
 
 	while( 1 )
 	{
-		c = getopt_long(argc, argv, "b:c:d:f:hi:I:l:m:op:s:t:u:v", options, &index);
+		c = getopt_long(argc, argv, "b:B:c:d:f:hi:I:l:m:M:op:s:t:u:v", options, &index);
 		if( c == -1 ) break;
 		switch( c )
 		{
@@ -195,6 +237,9 @@ static int parse_options( int argc, char *argv[], parsed_options_t *settings )
 		case 'b':
 			settings->iobase = strtol( optarg, NULL, 0 );
 			break;
+		case 'B':
+			settings->buffer_length = strtol( optarg, NULL, 0 );
+			break;
 		case 'c' :
 			free(settings->config_file);
 			settings->device_file = strdup( optarg );
@@ -224,6 +269,9 @@ static int parse_options( int argc, char *argv[], parsed_options_t *settings )
 		case 'm':
 			settings->minor = strtol( optarg, NULL, 0 );
 			break;
+		case 'M':
+			settings->max_buffer_length = strtol( optarg, NULL, 0 );
+			break;
 		case 'o':
 			settings->offline = 1;
 			break;
@@ -241,6 +289,18 @@ static int parse_options( int argc, char *argv[], parsed_options_t *settings )
 		case 'u':
 			settings->pci_bus = strtol( optarg, NULL, 0 );
 			break;
+		case poll_max_period_option:
+			settings->poll_max_period = strtol( optarg, NULL, 0 );
+			break;
+		case poll_min_period_option:
+			settings->poll_min_period = strtol( optarg, NULL, 0 );
+			break;
+		case busy_poll_option:
+			settings->busy_poll = strtol( optarg, NULL, 0 );
+			break;
+		case pio_poll_option:
+			settings->pio_poll = strtol( optarg, NULL, 0 );
+			break;
 		case 'v':
 		        ibvers(&version);
 			printf("linux-gpib version = %s\n",version);
@@ -280,6 +340,9 @@ static int configure_board( int fileno, const parsed_options_t *options )
 {
 	board_type_ioctl_t boardtype;
 	select_pci_ioctl_t pci_selection;
+	buffer_size_ioctl_t buffer_cmd;
+	pseudo_irq_ioctl_t pseudo_irq_cmd;
+	unsigned int pio_poll;
 	pad_ioctl_t pad_cmd;
 	sad_ioctl_t sad_cmd;
 	online_ioctl_t online_cmd;
@@ -345,6 +408,40 @@ static int configure_board( int fileno, const parsed_options_t *options )
 		fprintf(stderr, "failed to configure pci bus\n");
 		return retval;
 	}
+	if( options->buffer_length || options->max_buffer_length )
+	{
+		buffer_cmd.buffer_length = options->buffer_length;
+		buffer_cmd.max_buffer_length = options->max_buffer_length;
+		retval = ioctl( fileno, IBBUFFER_SIZE, &buffer_cmd );
+		if( retval < 0 )
+		{
+			fprintf(stderr, "failed to configure buffer size\n");
+			return retval;
+		}
+	}
+	if( options->poll_min_period >= 0 || options->poll_max_period >= 0 ||
+		options->busy_poll >= 0 )
+	{
+		pseudo_irq_cmd.min_period_usec = options->poll_min_period;
+		pseudo_irq_cmd.max_period_usec = options->poll_max_period;
+		pseudo_irq_cmd.busy_poll_usec = options->busy_poll;
+		retval = ioctl( fileno, IBPSEUDO_IRQ, &pseudo_irq_cmd );
+		if( retval < 0 )
+		{
+			fprintf(stderr, "failed to configure polling periods\n");
+			return retval;
+		}
+	}
+	if( options->pio_poll >= 0 )
+	{
+		pio_poll = options->pio_poll;
+		retval = ioctl( fileno, IBPIO_POLL, &pio_poll );
+		if( retval < 0 )
+		{
+			fprintf(stderr, "failed to configure pio poll window\n");
+			return retval;
+		}
+	}
 	online_cmd.online = 1;
 	assert(sizeof(options->init_data) <= sizeof(online_cmd.init_data_ptr));
 	online_cmd.init_data_ptr = (uintptr_t)options->init_data;
@@ -450,6 +547,18 @@ int main( int argc, char *argv[] )
 		options.pci_bus = board->pci_bus;
 	if( options.pci_slot < 0 )
 		options.pci_slot = board->pci_slot;
+	if( options.buffer_length == 0 )
+		options.buffer_length = board->buffer_length;
+	if( options.max_buffer_length == 0 )
+		options.max_buffer_length = board->max_buffer_length;
+	if( options.poll_min_period < 0 )
+		options.poll_min_period = board->poll_min_period;
+	if( options.poll_max_period < 0 )
+		options.poll_max_period = board->poll_max_period;
+	if( options.busy_poll < 0 )
+		options.busy_poll = board->busy_poll;
+	if( options.pio_poll < 0 )
+		options.pio_poll = board->pio_poll;
 	if( options.pad < 0 )
 	{
 		if( conf != NULL )
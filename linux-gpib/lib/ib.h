@@ -108,6 +108,7 @@ extern int ibloc( int ud );
 extern int ibonl( int ud, int onl );
 extern int ibpad( int ud, int v );
 extern int ibpct( int ud );
+extern int ibpollfd( int ud, int mask, int *fd );
 extern int ibppc( int ud, int v );
 extern int ibrd( int ud, void *buf, long count );
 extern int ibrda( int ud, void *buf, long count );
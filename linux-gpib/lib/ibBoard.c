@@ -29,6 +29,7 @@
 #include <signal.h>
 #include <pthread.h>
 #include <stdlib.h>
+#include <sys/mman.h>
 
 ibBoard_t ibBoard[ GPIB_MAX_NUM_BOARDS ];
 
@@ -40,9 +41,26 @@ void init_ibboard(ibBoard_t *board)
 	board->dma = 0;
 	board->pci_bus = -1;
 	board->pci_slot = -1;
+	board->buffer_length = 0;
+	board->max_buffer_length = 0;
+	board->poll_min_period = -1;
+	board->poll_max_period = -1;
+	board->busy_poll = -1;
+	board->pio_poll = -1;
 	board->fileno = -1;
 	strcpy(board->device, "");
 	board->open_count = 0;
+	board->state_page = NULL;
+	pthread_mutex_init( &board->info_lock, NULL );
+	board->info_generation = 0;
+	board->info_valid = 0;
+	board->usec_timeout = 0;
+	board->usec_timeout_generation = 0;
+	board->eos.eos = 0;
+	board->eos.eos_flags = 0;
+	board->eos_generation = 0;
+	board->usec_timeout_valid = 0;
+	board->eos_valid = 0;
 	board->is_system_controller = 0;
 	board->use_event_queue = 0;
 	board->autospoll = 0;
@@ -69,10 +87,30 @@ int configure_autospoll(ibConf_t *conf, int enable)
 	return retval;
 }
 
+/* Sets the length of the driver's transfer buffer.  Zero for max_length
+ * disables growing the buffer beyond length. */
+int configure_buffer_size( ibBoard_t *board, unsigned int length, unsigned int max_length )
+{
+	buffer_size_ioctl_t cmd;
+	int retval;
+
+	cmd.buffer_length = length;
+	cmd.max_buffer_length = max_length;
+	retval = ioctl( board->fileno, IBBUFFER_SIZE, &cmd );
+	if( retval < 0 )
+	{
+		setIberr( EDVR );
+		setIbcnt( errno );
+		fprintf( stderr, "libgpib: IBBUFFER_SIZE ioctl failed\n" );
+	}
+	return retval;
+}
+
 int ibBoardOpen( ibBoard_t *board )
 {
 	int fd;
 	int flags = 0;
+	void *state_page;
 
 	if( board->fileno >= 0 ) return 0;
 
@@ -87,9 +125,25 @@ int ibBoardOpen( ibBoard_t *board )
 	board->fileno = fd;
 	board->open_count++;
 
+	/* drivers too old to provide a state page just mean we can't cache board info */
+	state_page = mmap( NULL, sizeof( board_state_page_t ), PROT_READ, MAP_SHARED, fd, 0 );
+	if( state_page != MAP_FAILED )
+		board->state_page = state_page;
+	invalidate_board_cache( board );
+
 	return 0;
 }
 
+/* forget any board info and settings we remember pushing to the driver */
+void invalidate_board_cache( ibBoard_t *board )
+{
+	pthread_mutex_lock( &board->info_lock );
+	board->info_valid = 0;
+	board->usec_timeout_valid = 0;
+	board->eos_valid = 0;
+	pthread_mutex_unlock( &board->info_lock );
+}
+
 int ibBoardClose( ibBoard_t *board )
 {
 
@@ -103,6 +157,11 @@ int ibBoardClose( ibBoard_t *board )
 	if( board->open_count > 0 )
 		return 0;
 
+	if( board->state_page )
+	{
+		munmap( (void*) board->state_page, sizeof( board_state_page_t ) );
+		board->state_page = NULL;
+	}
 	if( board->fileno >= 0 )
 	{
 		close( board->fileno );
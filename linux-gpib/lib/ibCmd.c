@@ -129,7 +129,7 @@ ssize_t my_ibcmd( ibConf_t *conf, const uint8_t *buffer, size_t count)
 	return cmd.completed_transfer_count;
 }
 
-unsigned int create_send_setup( const ibBoard_t *board,
+unsigned int create_send_setup( ibBoard_t *board,
 	const Addr4882_t addressList[], uint8_t *cmdString )
 {
 	unsigned int i, j;
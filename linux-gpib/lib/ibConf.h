@@ -21,6 +21,8 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <pthread.h>
+#include <stdint.h>
+#include "gpib_ioctl.h"
 
 /* meaning for flags */
 
@@ -32,19 +34,15 @@
 
 /*---------------------------------------------------------------------- */
 
+/* asynchronous io operations are done by the driver (see IBAIO_START),
+ * this holds their results once they have been collected */
 struct async_operation
 {
-	pthread_t thread;	/* thread used for asynchronous io operations */
 	pthread_mutex_t lock;
-	pthread_mutex_t join_lock;
-	pthread_cond_t condition;
-	uint8_t *buffer;
-	volatile long buffer_length;
 	volatile int iberr;
 	volatile int ibsta;
 	volatile long ibcntl;
 	volatile short in_progress;
-	volatile short abort;
 };
 
 typedef struct
@@ -89,9 +87,26 @@ typedef struct ibBoardStruct {
 	unsigned int dma;
 	int pci_bus;
 	int pci_slot;
+	unsigned int buffer_length;	/* transfer buffer length, zero for driver default */
+	unsigned int max_buffer_length;	/* transfer buffer may grow up to this length */
+	int poll_min_period;	/* pseudo irq polling periods in microseconds, negative for driver default */
+	int poll_max_period;
+	int busy_poll;	/* microseconds a pseudo irq polled read may spin for a handshake */
+	int pio_poll;	/* microseconds pio reads spin for the next byte, negative for driver default */
 	int fileno;                        /* device file descriptor           */
 	char device[100];	/* name of device file ( /dev/gpib0, etc.) */
 	unsigned int open_count;	/* reference count */
+	const volatile board_state_page_t *state_page;	/* read-only page mmapped from driver */
+	pthread_mutex_t info_lock;	/* protects cached board info and settings shadows */
+	board_info_ioctl_t info;	/* cached result of IBBOARD_INFO ioctl */
+	uint32_t info_generation;	/* state_page->info_generation when info was cached */
+	unsigned int usec_timeout;	/* last timeout we set with IBTMO */
+	uint32_t usec_timeout_generation;	/* state_page->usec_timeout_generation after our IBTMO */
+	eos_ioctl_t eos;	/* last eos settings we set with IBEOS */
+	uint32_t eos_generation;	/* state_page->eos_generation after our IBEOS */
+	unsigned info_valid : 1;
+	unsigned usec_timeout_valid : 1;
+	unsigned eos_valid : 1;
 	unsigned is_system_controller : 1;	/* board is busmaster or not */
 	unsigned use_event_queue : 1;	/* use event queue, or DTAS/DCAS */
 	unsigned autospoll : 1; /* do auto serial polling */
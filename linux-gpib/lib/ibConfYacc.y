@@ -129,6 +129,8 @@ char cval;
 %token T_PAD T_SAD T_TIMO T_EOSBYTE T_BOARD_TYPE T_PCI_BUS T_PCI_SLOT
 %token T_REOS T_BIN T_INIT_S T_DCL T_XEOS T_EOT
 %token T_MASTER T_LLO T_EXCL T_INIT_F T_AUTOPOLL
+%token T_BUFFER_SIZE T_MAX_BUFFER_SIZE
+%token T_POLL_MIN_PERIOD T_POLL_MAX_PERIOD T_BUSY_POLL T_PIO_POLL
 
 %token T_NUMBER T_STRING T_BOOL T_TIVAL
 %type <ival> T_NUMBER
@@ -194,6 +196,12 @@ char cval;
 		| T_DMA  '=' T_NUMBER     { current_board( parse_arg )->dma = $3; }
 		| T_PCI_BUS  '=' T_NUMBER     { current_board( parse_arg )->pci_bus = $3; }
 		| T_PCI_SLOT  '=' T_NUMBER     { current_board( parse_arg )->pci_slot = $3; }
+		| T_BUFFER_SIZE  '=' T_NUMBER     { current_board( parse_arg )->buffer_length = $3; }
+		| T_MAX_BUFFER_SIZE  '=' T_NUMBER     { current_board( parse_arg )->max_buffer_length = $3; }
+		| T_POLL_MIN_PERIOD  '=' T_NUMBER     { current_board( parse_arg )->poll_min_period = $3; }
+		| T_POLL_MAX_PERIOD  '=' T_NUMBER     { current_board( parse_arg )->poll_max_period = $3; }
+		| T_BUSY_POLL  '=' T_NUMBER     { current_board( parse_arg )->busy_poll = $3; }
+		| T_PIO_POLL  '=' T_NUMBER     { current_board( parse_arg )->pio_poll = $3; }
 		| T_MASTER T_BOOL	{ gpib_conf_warn_missing_equals(); current_board( parse_arg )->is_system_controller = $2; }
 		| T_MASTER '=' T_BOOL	{ current_board( parse_arg )->is_system_controller = $3; }
 		| T_BOARD_TYPE '=' T_STRING
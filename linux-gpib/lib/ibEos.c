@@ -45,6 +45,7 @@ int config_read_eos( ibBoard_t *board, int use_eos_char, int eos_char,
 	int compare_8_bits )
 {
 	eos_ioctl_t eos_cmd;
+	uint32_t generation = 0;
 	int retval;
 
 	eos_cmd.eos_flags = 0;
@@ -66,7 +67,33 @@ int config_read_eos( ibBoard_t *board, int use_eos_char, int eos_char,
 		}
 	}
 
+	/* skip the ioctl if the board already has the eos settings we
+	 * last set, and nobody has done an IBEOS since */
+	if( board->state_page )
+	{
+		generation = board->state_page->eos_generation;
+		pthread_mutex_lock( &board->info_lock );
+		if( board->eos_valid && board->eos_generation == generation &&
+			board->eos.eos == eos_cmd.eos && board->eos.eos_flags == eos_cmd.eos_flags )
+		{
+			pthread_mutex_unlock( &board->info_lock );
+			return 0;
+		}
+		pthread_mutex_unlock( &board->info_lock );
+	}
+
 	retval = ioctl( board->fileno, IBEOS, &eos_cmd );
+
+	if( board->state_page )
+	{
+		pthread_mutex_lock( &board->info_lock );
+		board->eos = eos_cmd;
+		board->eos_generation = generation + 1;
+		board->eos_valid = retval == 0 &&
+			board->state_page->eos_generation == generation + 1;
+		pthread_mutex_unlock( &board->info_lock );
+	}
+
 	if( retval < 0 )
 	{
 		setIberr( EDVR );
@@ -105,6 +105,7 @@ int ibonl( int ud, int onl )
 
 	if( onl )
 	{
+		invalidate_board_cache( interfaceBoard( conf ) );
 		retval = reinit_descriptor( conf );
 		if( retval < 0 ) return exit_library( ud, 1 );
 		else return exit_library( ud, 0 );
@@ -127,23 +127,34 @@ int ibrd(int ud, void *rd, long cnt)
 	ibConf_t *conf;
 	ssize_t retval;
 	size_t bytes_read;
+	Addr4882_t address;
 
-	conf = enter_library( ud );
+	/* the board is locked by the IBXFER ioctl itself */
+	conf = general_enter_library( ud, 1, 0 );
 	if( conf == NULL )
-		return exit_library( ud, 1 );
+		return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
+
+	if( async_in_progress( conf ) )
+		return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
 
-	retval = my_ibrd(conf, rd, cnt, &bytes_read);
+	if( conf->is_interface )
+		address = NOADDR;
+	else
+		address = packAddress( conf->settings.pad, conf->settings.sad );
+
+	retval = xfer_read( conf, address, rd, cnt, conf->settings.eos,
+		conf->settings.eos_flags, &bytes_read );
 	if(retval < 0)
 	{
 		if(ThreadIberr() != EDVR)
 			setIbcnt(bytes_read);
-		return exit_library( ud, 1 );
+		return general_exit_library( ud, 1, 0, 1, 0, 0, 1 );
 	}else
 	{
 		setIbcnt(bytes_read);
 	}
 
-	return general_exit_library( ud, 0, 0, 0, DCAS, 0, 0 );
+	return general_exit_library( ud, 0, 0, 1, 0, 0, 1 );
 }
 
 int ibrda( int ud, void *buffer, long cnt )
@@ -341,20 +352,45 @@ void Receive( int boardID, Addr4882_t address,
 {
 	ibConf_t *conf;
 	int retval;
+	int eos_flags;
+	size_t bytes_read;
 
-	conf = enter_library( boardID );
+	/* the board is locked by the IBXFER ioctl itself */
+	conf = general_enter_library( boardID, 1, 0 );
 	if( conf == NULL )
 	{
-		exit_library( boardID, 1 );
+		general_exit_library( boardID, 1, 0, 0, 0, 0, 1 );
 		return;
 	}
 
-	retval = InternalReceive( conf, address, buffer, count, termination );
+	if( async_in_progress( conf ) )
+	{
+		general_exit_library( boardID, 1, 0, 0, 0, 0, 1 );
+		return;
+	}
+
+	if( conf->is_interface == 0 ||
+		addressIsValid( address ) == 0 || address == NOADDR ||
+		( termination != ( termination & 0xff ) && termination != STOPend ) )
+	{
+		setIberr( EARG );
+		general_exit_library( boardID, 1, 0, 0, 0, 0, 1 );
+		return;
+	}
+
+	if( termination != STOPend )
+		eos_flags = REOS | BIN;
+	else
+		eos_flags = 0;
+
+	retval = xfer_read( conf, address, buffer, count, termination, eos_flags,
+		&bytes_read );
+	setIbcnt( bytes_read );
 	if( retval < 0 )
 	{
-		exit_library( boardID, 1 );
+		general_exit_library( boardID, 1, 0, 1, 0, 0, 1 );
 		return;
 	}
 
-	general_exit_library( boardID, 0, 0, 0, DCAS, 0, 0 );
+	general_exit_library( boardID, 0, 0, 1, 0, 0, 1 );
 }
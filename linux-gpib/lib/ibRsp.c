@@ -16,6 +16,25 @@
  ***************************************************************************/
 
 #include "ib_internal.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+static void set_serial_poll_error( int error )
+{
+	switch( error )
+	{
+		case ETIMEDOUT:
+			setIberr( EABO );
+			break;
+		case EPIPE:
+			setIberr( ESTB );
+			break;
+		default:
+			setIberr( EDVR );
+			setIbcnt( error );
+			break;
+	}
+}
 
 static int serial_poll( ibBoard_t *board, unsigned int pad, int sad,
 	unsigned int usec_timeout, char *result )
@@ -31,19 +50,7 @@ static int serial_poll( ibBoard_t *board, unsigned int pad, int sad,
 	retval = ioctl( board->fileno, IBRSP, &poll_cmd );
 	if(retval < 0)
 	{
-		switch( errno )
-		{
-			case ETIMEDOUT:
-				setIberr( EABO );
-				break;
-			case EPIPE:
-				setIberr( ESTB );
-				break;
-			default:
-				setIberr( EDVR );
-				setIbcnt( errno );
-				break;
-		}
+		set_serial_poll_error( errno );
 		return -1;
 	}
 
@@ -52,6 +59,57 @@ static int serial_poll( ibBoard_t *board, unsigned int pad, int sad,
 	return 0;
 }
 
+/* Serial polls every address in addressList using a single IBRSP_LIST ioctl,
+ * so the bus only sees one SPE/SPD sequence.  *num_polled returns the number
+ * of status bytes stored in results, even on error. */
+static int serial_poll_list( ibBoard_t *board, const Addr4882_t addressList[],
+	unsigned int usec_timeout, int stop_on_rqs, short results[], unsigned int *num_polled )
+{
+	serial_poll_list_ioctl_t list_cmd;
+	serial_poll_ioctl_t *polls;
+	unsigned int num_addresses = numAddresses( addressList );
+	unsigned int i;
+	int retval;
+	int error;
+
+	*num_polled = 0;
+	if( num_addresses == 0 ) return 0;
+
+	polls = malloc( num_addresses * sizeof( serial_poll_ioctl_t ) );
+	if( polls == NULL )
+	{
+		setIberr( EDVR );
+		setIbcnt( ENOMEM );
+		return -1;
+	}
+	for( i = 0; i < num_addresses; i++ )
+	{
+		polls[ i ].pad = extractPAD( addressList[ i ] );
+		polls[ i ].sad = extractSAD( addressList[ i ] );
+		polls[ i ].status_byte = 0;
+	}
+	list_cmd.poll_list_ptr = ( uintptr_t ) polls;
+	list_cmd.num_polls = num_addresses;
+	list_cmd.usec_timeout = usec_timeout;
+	list_cmd.num_completed = 0;
+	list_cmd.stop_on_rqs = stop_on_rqs != 0;
+
+	retval = ioctl( board->fileno, IBRSP_LIST, &list_cmd );
+	error = errno;
+	*num_polled = list_cmd.num_completed;
+	for( i = 0; i < *num_polled; i++ )
+		results[ i ] = polls[ i ].status_byte & 0xff;
+	free( polls );
+	if( retval < 0 )
+	{
+		set_serial_poll_error( error );
+		errno = error;
+		return -1;
+	}
+
+	return 0;
+}
+
 int ibrsp(int ud, char *spr)
 {
 	ibConf_t *conf;
@@ -83,7 +141,7 @@ int ibrsp(int ud, char *spr)
 
 void AllSPoll( int boardID, const Addr4882_t addressList[], short resultList[] )
 {
-	int i;
+	unsigned int num_polled;
 	ibConf_t *conf;
 	ibBoard_t *board;
 	int retval;
@@ -116,22 +174,11 @@ void AllSPoll( int boardID, const Addr4882_t addressList[], short resultList[] )
 		return;
 	}
 
-	// XXX could use slightly more efficient ALLSPOLL protocol
-	retval = 0;
-	for( i = 0; i < numAddresses( addressList ); i++ )
-	{
-		char result;
-		retval = serial_poll( board, extractPAD( addressList[ i ] ),
-			extractSAD( addressList[ i ] ), conf->settings.spoll_usec_timeout, &result );
-		if( retval < 0 )
-		{
-			if( errno == ETIMEDOUT )
-				conf->timed_out = 1;
-			break;
-		}
-		resultList[ i ] = result & 0xff;
-	}
-	setIbcnt( i );
+	retval = serial_poll_list( board, addressList, conf->settings.spoll_usec_timeout,
+		0, resultList, &num_polled );
+	if( retval < 0 && errno == ETIMEDOUT )
+		conf->timed_out = 1;
+	setIbcnt( num_polled );
 
 	if( retval < 0 ) exit_library( boardID, 1 );
 	else exit_library( boardID, 0 );
@@ -144,7 +191,8 @@ void AllSpoll( int boardID, const Addr4882_t addressList[], short resultList[] )
 
 void FindRQS( int boardID, const Addr4882_t addressList[], short *result )
 {
-	int i;
+	unsigned int i, num_addresses, num_polled;
+	short *results;
 	ibConf_t *conf;
 	ibBoard_t *board;
 	int retval;
@@ -177,26 +225,31 @@ void FindRQS( int boardID, const Addr4882_t addressList[], short *result )
 		return;
 	}
 
-	retval = 0;
-	for( i = 0; i < numAddresses( addressList ); i++ )
+	num_addresses = numAddresses( addressList );
+	results = malloc( num_addresses * sizeof( short ) );
+	if( results == NULL )
 	{
-		char spoll_byte;
-		retval = serial_poll( board, extractPAD( addressList[ i ] ),
-			extractSAD( addressList[ i ] ), conf->settings.usec_timeout, &spoll_byte );
-		if( retval < 0 )
-		{
-			if( errno == ETIMEDOUT )
-				conf->timed_out = 1;
-			break;
-		}
-		if( spoll_byte & request_service_bit )
-		{
-			*result = spoll_byte & 0xff;
-			break;
-		}
+		setIberr( EDVR );
+		setIbcnt( ENOMEM );
+		exit_library( boardID, 1 );
+		return;
 	}
+	retval = serial_poll_list( board, addressList, conf->settings.usec_timeout,
+		1, results, &num_polled );
+	if( retval < 0 )
+	{
+		if( errno == ETIMEDOUT )
+			conf->timed_out = 1;
+		i = num_polled;
+	}else if( num_polled > 0 && ( results[ num_polled - 1 ] & request_service_bit ) )
+	{
+		i = num_polled - 1;
+		*result = results[ i ];
+	}else
+		i = num_addresses;
+	free( results );
 	setIbcnt( i );
-	if( i == numAddresses( addressList ) )
+	if( i == num_addresses )
 	{
 		setIberr( ETAB );
 		retval = -1;
@@ -18,7 +18,7 @@
 #include "ib_internal.h"
 #include <stdlib.h>
 
-int remote_enable( const ibBoard_t *board, int enable )
+int remote_enable( ibBoard_t *board, int enable )
 {
 	int retval;
 
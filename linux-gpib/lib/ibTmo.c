@@ -152,9 +152,40 @@ int ibtmo(int ud, int v )
 	return general_exit_library( ud, 0, 0, 0, 0, 0, 1 );
 }
 
-int set_timeout( const ibBoard_t *board, unsigned int usec_timeout)
+/* Skips the IBTMO ioctl if the board already has the timeout we last
+ * set, and nobody has done an IBTMO since. */
+int set_timeout( ibBoard_t *board, unsigned int usec_timeout)
 {
-       return ioctl( board->fileno, IBTMO, &usec_timeout);
+	uint32_t generation = 0;
+	int retval;
+
+	if( board->state_page )
+	{
+		generation = board->state_page->usec_timeout_generation;
+		pthread_mutex_lock( &board->info_lock );
+		if( board->usec_timeout_valid && board->usec_timeout_generation == generation &&
+			board->usec_timeout == usec_timeout )
+		{
+			pthread_mutex_unlock( &board->info_lock );
+			return 0;
+		}
+		pthread_mutex_unlock( &board->info_lock );
+	}
+
+	retval = ioctl( board->fileno, IBTMO, &usec_timeout);
+
+	if( board->state_page )
+	{
+		pthread_mutex_lock( &board->info_lock );
+		/* only trust the shadow if our ioctl was the one and only IBTMO since
+		 * we sampled the generation */
+		board->usec_timeout = usec_timeout;
+		board->usec_timeout_generation = generation + 1;
+		board->usec_timeout_valid = retval == 0 &&
+			board->state_page->usec_timeout_generation == generation + 1;
+		pthread_mutex_unlock( &board->info_lock );
+	}
+	return retval;
 }
 
 
@@ -47,7 +47,11 @@ int my_wait( ibConf_t *conf, int wait_mask, int clear_mask, int set_mask, int *s
 
 	board = interfaceBoard( conf );
 
+	/* A plain status query has no side effects, so the CIC check for
+	 * device descriptors can use the status it returns instead of
+	 * costing an extra ioctl. */
 	if( conf->is_interface == 0 &&
+		( wait_mask || clear_mask || set_mask ) &&
 		is_cic( board ) == 0 )
 	{
 		setIberr( ECIC );
@@ -86,6 +90,13 @@ int my_wait( ibConf_t *conf, int wait_mask, int clear_mask, int set_mask, int *s
 		setIbcnt( errno );
 		return -1;
 	}
+	if( conf->is_interface == 0 &&
+		( wait_mask || clear_mask || set_mask ) == 0 &&
+		( cmd.ibsta & CIC ) == 0 )
+	{
+		setIberr( ECIC );
+		return -1;
+	}
 	fixup_status_bits( conf, &cmd.ibsta );
 	if( conf->end ) //XXX
 		cmd.ibsta |= END;
@@ -114,7 +125,7 @@ int ibwait( int ud, int mask )
 //XXX
 	if(conf->async.in_progress && (status & CMPL))
 	{
-		if( gpib_aio_join( &conf->async ) )
+		if( gpib_aio_complete( conf ) )
 			error++;
 		pthread_mutex_lock( &conf->async.lock );
 		if( conf->async.ibsta & CMPL )
@@ -140,6 +151,45 @@ int ibwait( int ud, int mask )
 	return status;
 }
 
+/* Makes poll() on the returned file descriptor report readable once any
+ * status bit in mask is set for ud.  Descriptors on the same board share
+ * the file descriptor, so use ibwait( ud, 0 ) to see which one is ready.
+ * A mask of zero stops ud from making poll() return. */
+int ibpollfd( int ud, int mask, int *fd )
+{
+	ibConf_t *conf;
+	ibBoard_t *board;
+	poll_mask_ioctl_t cmd;
+	int wait_mask;
+	int retval;
+
+	conf = general_enter_library( ud, 1, 0 );
+	if( conf == NULL )
+		return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
+
+	wait_mask = mask;
+	fixup_status_bits( conf, &wait_mask );
+	if( wait_mask != mask || ( mask & TIMO ) )
+	{
+		setIberr( EARG );
+		return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
+	}
+
+	board = interfaceBoard( conf );
+	cmd.handle = conf->handle;
+	cmd.wait_mask = mask;
+	retval = ioctl( board->fileno, IBPOLL_MASK, &cmd );
+	if( retval < 0 )
+	{
+		setIberr( EDVR );
+		setIbcnt( errno );
+		return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
+	}
+	*fd = board->fileno;
+
+	return general_exit_library( ud, 0, 0, 0, 0, 0, 1 );
+}
+
 void WaitSRQ( int boardID, short *result )
 {
 	ibConf_t *conf;
@@ -160,32 +160,93 @@ int ibwrt( int ud, const void *rd, long cnt )
 	ibConf_t *conf;
 	size_t count;
 	int retval;
+	Addr4882_t address;
 	
-	conf = enter_library( ud );
+	/* the board is locked by the IBXFER ioctl itself */
+	conf = general_enter_library( ud, 1, 0 );
 	if( conf == NULL )
-		return exit_library( ud, 1 );
+		return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
+
+	if( async_in_progress( conf ) )
+		return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
 
 	conf->end = 0;
 
-	retval = my_ibwrt(conf, rd, cnt, &count);
+	/* asserting EOI on the eos character may split the write into
+	 * several pieces, so it has to be done while holding the board lock */
+	if( conf->settings.eos_flags & XEOS )
+	{
+		if( conf_lock_board( conf ) < 0 )
+			return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
+
+		retval = my_ibwrt(conf, rd, cnt, &count);
+		if(retval < 0)
+		{
+			if(ThreadIberr() != EDVR) setIbcnt(count);
+			return exit_library( ud, 1 );
+		}
+		setIbcnt(count);
+		return general_exit_library( ud, 0, 0, 0, DCAS, 0, 0 );
+	}
+
+	if( conf->is_interface )
+		address = NOADDR;
+	else
+		address = packAddress( conf->settings.pad, conf->settings.sad );
+
+	retval = xfer_write( conf, address, rd, cnt, conf->settings.send_eoi, &count );
 	if(retval < 0)
 	{
 		if(ThreadIberr() != EDVR) setIbcnt(count);
-		return exit_library( ud, 1 );
+		return general_exit_library( ud, 1, 0, 1, 0, 0, 1 );
 	}
 	setIbcnt(count);
-	return general_exit_library( ud, 0, 0, 0, DCAS, 0, 0 );
+	return general_exit_library( ud, 0, 0, 1, 0, 0, 1 );
 }
 
 int ibwrta( int ud, const void *buffer, long cnt )
 {
 	ibConf_t *conf;
+	size_t count;
 	int retval;
 
 	conf = general_enter_library( ud, 1, 0 );
 	if( conf == NULL )
 		return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
 
+	/* the driver does an asynchronous write as a single transfer, which
+	 * can't assert EOI on each eos character.  So those writes are done
+	 * now, and their results left for ibwait() to collect just as if they
+	 * had finished in the background. */
+	if( conf->settings.eos_flags & XEOS )
+	{
+		if( async_in_progress( conf ) )
+			return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
+		if( conf_lock_board( conf ) < 0 )
+			return general_exit_library( ud, 1, 0, 0, 0, 0, 1 );
+
+		conf->end = 0;
+		retval = my_ibwrt( conf, buffer, cnt, &count );
+		pthread_mutex_lock( &conf->async.lock );
+		if( retval < 0 )
+		{
+			if( ThreadIberr() != EDVR )
+				conf->async.ibcntl = count;
+			else
+				conf->async.ibcntl = ThreadIbcntl();
+			conf->async.iberr = ThreadIberr();
+			conf->async.ibsta = CMPL | ERR;
+		}else
+		{
+			conf->async.ibcntl = count;
+			conf->async.iberr = 0;
+			conf->async.ibsta = CMPL;
+		}
+		conf->async.in_progress = 1;
+		pthread_mutex_unlock( &conf->async.lock );
+		return general_exit_library( ud, 0, 0, 0, DCAS, 0, 0 );
+	}
+
 	retval = gpib_aio_launch( ud, conf, GPIB_AIO_WRITE,
 		(void*)buffer, cnt );
 	if( retval < 0 )
@@ -420,12 +481,68 @@ void SendList( int boardID, const Addr4882_t addressList[],
 void Send( int boardID, Addr4882_t address, const void *buffer, long count,
 	int eotmode )
 {
-	Addr4882_t addressList[ 2 ];
+	ibConf_t *conf;
+	int retval;
+	size_t num_bytes;
+	size_t bytes_written = 0;
 
-	addressList[ 0 ] = address;
-	addressList[ 1 ] = NOADDR;
+	conf = general_enter_library( boardID, 1, 0 );
+	if( conf == NULL )
+	{
+		general_exit_library( boardID, 1, 0, 0, 0, 0, 1 );
+		return;
+	}
+
+	if( async_in_progress( conf ) )
+	{
+		general_exit_library( boardID, 1, 0, 0, 0, 0, 1 );
+		return;
+	}
+
+	if( conf->is_interface == 0 ||
+		addressIsValid( address ) == 0 || address == NOADDR )
+	{
+		setIberr( EARG );
+		general_exit_library( boardID, 1, 0, 0, 0, 0, 1 );
+		return;
+	}
+
+	switch( eotmode )
+	{
+		case DABend:
+		case NULLend:
+			/* the board is locked by the IBXFER ioctl itself */
+			break;
+		case NLend:
+			/* hold the board lock so the newline follows the data */
+			if( conf_lock_board( conf ) < 0 )
+			{
+				general_exit_library( boardID, 1, 0, 0, 0, 0, 1 );
+				return;
+			}
+			break;
+		default:
+			setIberr( EARG );
+			general_exit_library( boardID, 1, 0, 0, 0, 0, 1 );
+			return;
+			break;
+	}
+
+	retval = xfer_write( conf, address, buffer, count, eotmode == DABend, &num_bytes );
+	bytes_written += num_bytes;
+	if( retval == 0 && eotmode == NLend )
+	{
+		retval = xfer_write( conf, NOADDR, "\n", 1, 1, &num_bytes );
+		bytes_written += num_bytes;
+	}
+	setIbcnt( bytes_written );
+	if( retval < 0 )
+	{
+		general_exit_library( boardID, 1, 0, 1, 0, 0, 0 );
+		return;
+	}
 
-	SendList( boardID, addressList, buffer, count, eotmode );
+	general_exit_library( boardID, 0, 0, 1, 0, 0, 0 );
 }
 
 
@@ -35,9 +35,12 @@ enum internal_gpib_addr
 };
 
 int my_wait( ibConf_t *conf, int wait_mask, int clear_mask, int set_mask, int *status );
+void fixup_status_bits( const ibConf_t *conf, int *status );
 void init_async_op( struct async_operation *async );
 int ibBoardOpen( ibBoard_t *board );
 int ibBoardClose( ibBoard_t *board );
+void invalidate_board_cache( ibBoard_t *board );
+int configure_buffer_size( ibBoard_t *board, unsigned int length, unsigned int max_length );
 int ibGetNrBoards(void);
 int iblcleos( const ibConf_t *conf );
 void ibPutMsg (char *format,...);
@@ -49,7 +52,7 @@ ssize_t my_ibcmd( ibConf_t *conf, const uint8_t *buffer, size_t length);
 ssize_t my_ibrd( ibConf_t *conf, uint8_t *buffer, size_t count, size_t *bytes_read);
 int my_ibwrt( ibConf_t *conf, const uint8_t *buffer, size_t count, size_t *bytes_written);
 unsigned int send_setup_string( const ibConf_t *conf, uint8_t *cmdString );
-unsigned int create_send_setup( const ibBoard_t *board,
+unsigned int create_send_setup( ibBoard_t *board,
 	const Addr4882_t addressList[], uint8_t *cmdString );
 int send_setup( ibConf_t *conf );
 void init_ibconf( ibConf_t *conf );
@@ -59,7 +62,7 @@ int my_ibbna( ibConf_t *conf, unsigned int new_board_index );
 unsigned int timeout_to_usec( enum gpib_timeout timeout );
 unsigned int ppoll_timeout_to_usec( unsigned int timeout );
 unsigned int usec_to_ppoll_timeout( unsigned int usec );
-int set_timeout( const ibBoard_t *board, unsigned int usec_timeout );
+int set_timeout( ibBoard_t *board, unsigned int usec_timeout );
 int close_gpib_handle( ibConf_t *conf );
 int open_gpib_handle( ibConf_t *conf );
 int gpibi_change_address( ibConf_t *conf,
@@ -74,14 +77,24 @@ int general_exit_library( int ud, int error, int no_sync_globals, int no_update_
 	int status_clear_mask, int status_set_mask, int no_unlock_board );
 ibConf_t * enter_library( int ud );
 ibConf_t * general_enter_library( int ud, int no_lock_board, int ignore_eoip );
+int async_in_progress( ibConf_t *conf );
+int xfer_read( ibConf_t *conf, Addr4882_t address, void *buffer, size_t count,
+	int eos, int eos_flags, size_t *bytes_read );
+int xfer_write( ibConf_t *conf, Addr4882_t address, const void *buffer, size_t count,
+	int send_eoi, size_t *bytes_written );
+void init_xfer_cmd( const ibConf_t *conf, xfer_ioctl_t *cmd, Addr4882_t address, int write,
+	void *buffer, size_t count, int eos, int eos_flags, int send_eoi );
+void finish_xfer( ibConf_t *conf, const xfer_ioctl_t *cmd, int retval );
 void setIbsta( int status );
 void setIberr( int error );
 void setIbcnt( long count );
 unsigned int usec_to_timeout( unsigned int usec );
-int query_ppc( const ibBoard_t *board );
-int query_ist( const ibBoard_t *board );
-int query_pad( const ibBoard_t *board, unsigned int *pad );
-int query_sad( const ibBoard_t *board, int *sad );
+int query_board_info( ibBoard_t *board, board_info_ioctl_t *info );
+int query_ppc( ibBoard_t *board );
+int query_ist( ibBoard_t *board );
+int query_pad( ibBoard_t *board, unsigned int *pad );
+int query_sad( ibBoard_t *board, int *sad );
+int query_buffer_size( ibBoard_t *board, int max );
 int conf_online( ibConf_t *conf, int online );
 int configure_autospoll( ibConf_t *conf, int enable );
 int extractPAD( Addr4882_t address );
@@ -90,11 +103,11 @@ Addr4882_t packAddress( unsigned int pad, int sad );
 int addressIsValid( Addr4882_t address );
 int addressListIsValid( const Addr4882_t addressList[] );
 unsigned int numAddresses( const Addr4882_t addressList[] );
-int remote_enable( const ibBoard_t *board, int enable );
+int remote_enable( ibBoard_t *board, int enable );
 int config_read_eos( ibBoard_t *board, int use_eos_char,
 	int eos_char, int compare_8_bits );
 void sync_globals( void );
-int is_system_controller( const ibBoard_t *board );
+int is_system_controller( ibBoard_t *board );
 int is_cic( const ibBoard_t *board );
 int assert_ifc( ibBoard_t *board, unsigned int usec );
 int request_system_control( ibBoard_t *board, int request_control );
@@ -141,6 +154,6 @@ enum gpib_aio_varieties
 };
 int gpib_aio_launch( int ud, ibConf_t *conf, int gpib_aio_type,
 	void *buffer, long cnt );
-int gpib_aio_join( struct async_operation *async );
+int gpib_aio_complete( ibConf_t *conf );
 
 #endif	/* _IB_INTERNAL_H */
@@ -17,12 +17,27 @@
 
 #include "ib_internal.h"
 
-int query_ist( const ibBoard_t *board )
+/* Gets the board info, using the cached copy as long as the driver's
+ * state page says nothing has changed since we last asked. */
+int query_board_info( ibBoard_t *board, board_info_ioctl_t *info )
 {
 	int retval;
-	board_info_ioctl_t info;
+	uint32_t generation = 0;
 
-	retval = ioctl( board->fileno, IBBOARD_INFO, &info );
+	if( board->state_page )
+	{
+		generation = board->state_page->info_generation;
+		pthread_mutex_lock( &board->info_lock );
+		if( board->info_valid && board->info_generation == generation )
+		{
+			*info = board->info;
+			pthread_mutex_unlock( &board->info_lock );
+			return 0;
+		}
+		pthread_mutex_unlock( &board->info_lock );
+	}
+
+	retval = ioctl( board->fileno, IBBOARD_INFO, info );
 	if( retval < 0 )
 	{
 		setIberr( EDVR );
@@ -30,53 +45,58 @@ int query_ist( const ibBoard_t *board )
 		return retval;
 	}
 
+	if( board->state_page )
+	{
+		pthread_mutex_lock( &board->info_lock );
+		board->info = *info;
+		board->info_generation = generation;
+		board->info_valid = 1;
+		pthread_mutex_unlock( &board->info_lock );
+	}
+
+	return 0;
+}
+
+int query_ist( ibBoard_t *board )
+{
+	int retval;
+	board_info_ioctl_t info;
+
+	retval = query_board_info( board, &info );
+	if( retval < 0 ) return retval;
+
 	return info.ist;
 }
 
-int query_ppc( const ibBoard_t *board )
+int query_ppc( ibBoard_t *board )
 {
 	int retval;
 	board_info_ioctl_t info;
 
-	retval = ioctl( board->fileno, IBBOARD_INFO, &info );
-	if( retval < 0 )
-	{
-		setIberr( EDVR );
-		setIbcnt( errno );
-		return retval;
-	}
+	retval = query_board_info( board, &info );
+	if( retval < 0 ) return retval;
 
 	return info.parallel_poll_configuration;
 }
 
-int query_autopoll( const ibBoard_t *board )
+int query_autopoll( ibBoard_t *board )
 {
 	int retval;
 	board_info_ioctl_t info;
 
-	retval = ioctl( board->fileno, IBBOARD_INFO, &info );
-	if( retval < 0 )
-	{
-		setIberr( EDVR );
-		setIbcnt( errno );
-		return retval;
-	}
+	retval = query_board_info( board, &info );
+	if( retval < 0 ) return retval;
 
 	return info.autopolling;
 }
 
-int query_board_t1_delay( const ibBoard_t *board )
+int query_board_t1_delay( ibBoard_t *board )
 {
 	int retval;
 	board_info_ioctl_t info;
 
-	retval = ioctl( board->fileno, IBBOARD_INFO, &info );
-	if( retval < 0 )
-	{
-		setIberr( EDVR );
-		setIbcnt( errno );
-		return retval;
-	}
+	retval = query_board_info( board, &info );
+	if( retval < 0 ) return retval;
 
 	if(info.t1_delay == 0)
 	{
@@ -104,55 +124,52 @@ int query_board_rsv( const ibBoard_t *board )
 	return status;
 }
 
-int query_pad( const ibBoard_t *board, unsigned int *pad )
+int query_pad( ibBoard_t *board, unsigned int *pad )
 {
 	int retval;
 	board_info_ioctl_t info;
 
-	retval = ioctl( board->fileno, IBBOARD_INFO, &info );
-	if( retval < 0 )
-	{
-		setIberr( EDVR );
-		setIbcnt( errno );
-		return retval;
-	}
+	retval = query_board_info( board, &info );
+	if( retval < 0 ) return retval;
 
 	*pad = info.pad;
 	return 0;
 }
 
-int query_sad( const ibBoard_t *board, int *sad )
+int query_sad( ibBoard_t *board, int *sad )
 {
 	int retval;
 	board_info_ioctl_t info;
 
-	retval = ioctl( board->fileno, IBBOARD_INFO, &info );
-	if( retval < 0 )
-	{
-		setIberr( EDVR );
-		setIbcnt( errno );
-		return retval;
-	}
+	retval = query_board_info( board, &info );
+	if( retval < 0 ) return retval;
 
 	*sad = info.sad;
 	return 0;
 }
 
-int query_no_7_bit_eos(const ibBoard_t *board)
+int query_no_7_bit_eos( ibBoard_t *board )
 {
 	int retval;
 	board_info_ioctl_t info;
 
-	retval = ioctl(board->fileno, IBBOARD_INFO, &info);
-	if( retval < 0 )
-	{
-		setIberr( EDVR );
-		setIbcnt( errno );
-		return retval;
-	}
+	retval = query_board_info( board, &info );
+	if( retval < 0 ) return retval;
+
 	return info.no_7_bit_eos;
 }
 
+int query_buffer_size( ibBoard_t *board, int max )
+{
+	int retval;
+	board_info_ioctl_t info;
+
+	retval = query_board_info( board, &info );
+	if( retval < 0 ) return retval;
+
+	return max ? info.max_buffer_length : info.buffer_length;
+}
+
 int ibask( int ud, int option, int *value )
 {
 	ibConf_t *conf;
@@ -196,6 +213,10 @@ int ibask( int ud, int option, int *value )
 			*value = usec_to_timeout( conf->settings.usec_timeout );
 			return exit_library( ud, 0 );
 			break;
+		case IbaTMOusec:
+			*value = conf->settings.usec_timeout;
+			return exit_library( ud, 0 );
+			break;
 		case IbaEOT:
 			*value = conf->settings.send_eoi;
 			return exit_library( ud, 0 );
@@ -306,6 +327,10 @@ int ibask( int ud, int option, int *value )
 				*value = usec_to_ppoll_timeout( conf->settings.ppoll_usec_timeout );
 				return exit_library( ud, 0 );
 				break;
+			case IbaPPollTimeUsec:
+				*value = conf->settings.ppoll_usec_timeout;
+				return exit_library( ud, 0 );
+				break;
 			case IbaHSCableLength:
 				/* HS transfer not supported and may never
 				 * be as it is not part of GPIB standard */
@@ -330,6 +355,13 @@ int ibask( int ud, int option, int *value )
 				*value = !retval;
 				return exit_library( ud, 0 );
 				break;
+			case IbaBufferSize:
+			case IbaMaxBufferSize:
+				retval = query_buffer_size( board, option == IbaMaxBufferSize );
+				if( retval < 0 ) return exit_library( ud, 1 );
+				*value = retval;
+				return exit_library( ud, 0 );
+				break;
 			default:
 				break;
 		}
@@ -345,6 +377,10 @@ int ibask( int ud, int option, int *value )
 				*value = usec_to_timeout( conf->settings.spoll_usec_timeout );
 				return exit_library( ud, 0 );
 				break;
+			case IbaSPollTimeUsec:
+				*value = conf->settings.spoll_usec_timeout;
+				return exit_library( ud, 0 );
+				break;
 			case IbaUnAddr:
 				/* XXX sending UNT and UNL after device level read/write
 				 * not supported yet, I suppose it could be since it
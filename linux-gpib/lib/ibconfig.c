@@ -77,6 +77,24 @@ static int set_t1_delay( ibBoard_t *board, int delay )
 	return 0;
 }
 
+static int set_buffer_size( ibBoard_t *board, int option, int value )
+{
+	board_info_ioctl_t info;
+	int retval;
+
+	if( value <= 0 )
+	{
+		setIberr( EARG );
+		return -1;
+	}
+	retval = query_board_info( board, &info );
+	if( retval < 0 ) return retval;
+	if( option == IbcBufferSize )
+		return configure_buffer_size( board, value, info.max_buffer_length );
+	else
+		return configure_buffer_size( board, info.buffer_length, value );
+}
+
 int ibconfig( int ud, int option, int value )
 {
 	ibConf_t *conf;
@@ -103,6 +121,15 @@ int ibconfig( int ud, int option, int value )
 			if( retval < 0 ) return exit_library( ud, 1 );
 			return exit_library( ud, 0 );
 			break;
+		case IbcTMOusec:
+			if( value < 0 )
+			{
+				setIberr( EARG );
+				return exit_library( ud, 1 );
+			}
+			conf->settings.usec_timeout = value;
+			return exit_library( ud, 0 );
+			break;
 		case IbcEOT:
 			internal_ibeot( conf, value );
 			return exit_library( ud, 0 );
@@ -279,6 +306,15 @@ int ibconfig( int ud, int option, int value )
 					return exit_library( ud, 0 );
 				}
 				break;
+			case IbcPPollTimeUsec:
+				if( value <= 0 )
+				{
+					setIberr( EARG );
+					return exit_library( ud, 1 );
+				}
+				conf->settings.ppoll_usec_timeout = value;
+				return exit_library( ud, 0 );
+				break;
 			case IbcHSCableLength:
 				// XXX
 				if( value )
@@ -301,6 +337,12 @@ int ibconfig( int ud, int option, int value )
 				else
 					return exit_library( ud, 0 );
 				break;
+			case IbcBufferSize:
+			case IbcMaxBufferSize:
+				retval = set_buffer_size( interfaceBoard( conf ), option, value );
+				if( retval < 0 ) return exit_library( ud, 1 );
+				return exit_library( ud, 0 );
+				break;
 			default:
 				break;
 		}
@@ -330,6 +372,15 @@ int ibconfig( int ud, int option, int value )
 					return exit_library( ud, 0 );
 				}
 				break;
+			case IbcSPollTimeUsec:
+				if( value < 0 )
+				{
+					setIberr( EARG );
+					return exit_library( ud, 1 );
+				}
+				conf->settings.spoll_usec_timeout = value;
+				return exit_library( ud, 0 );
+				break;
 			case IbcUnAddr:
 				// XXX
 				if( value )
@@ -27,14 +27,16 @@ int internal_ibstop( ibConf_t *conf )
 		pthread_mutex_unlock( &conf->async.lock );
 		return 0;
 	}
-	retval = pthread_cancel( conf->async.thread );
-	if( retval )
+	pthread_mutex_unlock( &conf->async.lock );
+
+	retval = ioctl( interfaceBoard( conf )->fileno, IBAIO_CANCEL, &conf->handle );
+	if( retval < 0 )
 	{
-		pthread_mutex_unlock( &conf->async.lock );
-		return 0;
+		setIberr( EDVR );
+		setIbcnt( errno );
+		return -1;
 	}
-	pthread_mutex_unlock( &conf->async.lock );
-	retval = gpib_aio_join( &conf->async );
+	retval = gpib_aio_complete( conf );
 	if( retval )
 	{
 		return -1;
@@ -23,6 +23,7 @@
 #include <string.h>
 #include <pthread.h>
 #include <assert.h>
+#include <stdint.h>
 #include "parse.h"
 
 ibConf_t *ibConfigs[ GPIB_CONFIGS_LENGTH ] = {NULL};
@@ -110,7 +111,6 @@ static void gpib_atfork_prepare(void)
 		if(ibConfigs[i])
 		{
 			pthread_mutex_lock(&ibConfigs[i]->async.lock);
-			pthread_mutex_lock(&ibConfigs[i]->async.join_lock);
 		}
 	pthread_mutex_lock(&config_lock);
 }
@@ -123,7 +123,6 @@ static void gpib_atfork_parent(void)
 	for(i = 0; i < GPIB_CONFIGS_LENGTH; i++)
 		if(ibConfigs[i])
 		{
-			pthread_mutex_unlock(&ibConfigs[i]->async.join_lock);
 			pthread_mutex_unlock(&ibConfigs[i]->async.lock);
 		}
 }
@@ -136,9 +135,14 @@ static void gpib_atfork_child(void)
 	for(i = 0; i < GPIB_CONFIGS_LENGTH; i++)
 		if(ibConfigs[i])
 		{
-			pthread_mutex_init(&ibConfigs[i]->async.join_lock, NULL);
 			pthread_mutex_init(&ibConfigs[i]->async.lock, NULL);
 		}
+	/* another thread may have been holding info_lock when we forked */
+	for(i = 0; i < GPIB_MAX_NUM_BOARDS; i++)
+	{
+		pthread_mutex_init(&ibBoard[i].info_lock, NULL);
+		invalidate_board_cache(&ibBoard[i]);
+	}
 }
 
 int ibParseConfigFile( void )
@@ -441,16 +445,9 @@ ibConf_t * general_enter_library( int ud, int no_lock_board, int ignore_eoip )
 
 	if( no_lock_board == 0 )
 	{
-		if( ignore_eoip == 0 )
+		if( ignore_eoip == 0 && async_in_progress( conf ) )
 		{
-			pthread_mutex_lock( &conf->async.lock );
-			if( conf->async.in_progress )
-			{
-				pthread_mutex_unlock( &conf->async.lock );
-				setIberr( EOIP );
-				return NULL;
-			}
-			pthread_mutex_unlock( &conf->async.lock );
+			return NULL;
 		}
 
 		retval = conf_lock_board( conf );
@@ -463,6 +460,148 @@ ibConf_t * general_enter_library( int ud, int no_lock_board, int ignore_eoip )
 	return conf;
 }
 
+/* returns nonzero and sets EOIP error if an asynchronous io operation
+ * is in progress on conf */
+int async_in_progress( ibConf_t *conf )
+{
+	int in_progress;
+
+	pthread_mutex_lock( &conf->async.lock );
+	in_progress = conf->async.in_progress;
+	pthread_mutex_unlock( &conf->async.lock );
+
+	if( in_progress )
+		setIberr( EOIP );
+
+	return in_progress;
+}
+
+/* Fills in the argument of an IBXFER or IBAIO_START ioctl.  If address is
+ * not NOADDR, the device at address is addressed before the transfer. */
+void init_xfer_cmd( const ibConf_t *conf, xfer_ioctl_t *cmd, Addr4882_t address, int write,
+	void *buffer, size_t count, int eos, int eos_flags, int send_eoi )
+{
+	assert(sizeof(buffer) <= sizeof(cmd->buffer_ptr));
+	cmd->buffer_ptr = (uintptr_t)buffer;
+	cmd->requested_transfer_count = count;
+	cmd->completed_transfer_count = 0;
+	cmd->usec_timeout = conf->settings.usec_timeout;
+	cmd->handle = conf->handle;
+	cmd->address_target = address != NOADDR;
+	if( cmd->address_target )
+	{
+		cmd->pad = extractPAD( address );
+		cmd->sad = extractSAD( address );
+	}else
+	{
+		cmd->pad = 0;
+		cmd->sad = SAD_DISABLED;
+	}
+	cmd->eos = eos & 0xff;
+	cmd->eos_flags = eos_flags & ( REOS | BIN );
+	cmd->end = send_eoi;
+	cmd->ibsta = 0;
+	cmd->write = write != 0;
+	cmd->command = 0;
+}
+
+/* Sets iberr (on failure) and conf->end from the results of an IBXFER or
+ * IBAIO_COMPLETE ioctl which returned retval. */
+void finish_xfer( ibConf_t *conf, const xfer_ioctl_t *cmd, int retval )
+{
+	if( retval < 0 )
+	{
+		/* addressing fails with EIO when we aren't controller-in-charge.
+		 * Errors before the transfer starts leave ibsta zero. */
+		if( errno == EIO && cmd->address_target &&
+			cmd->ibsta != 0 && ( cmd->ibsta & CIC ) == 0 )
+		{
+			setIberr( ECIC );
+		}else
+		{
+			switch( errno )
+			{
+				case ETIMEDOUT:
+					conf->timed_out = 1;
+					setIberr( EABO );
+					break;
+				case EINTR:
+				case ECANCELED:
+					setIberr( EABO );
+					break;
+				case EIO:
+					if( cmd->write )
+					{
+						setIberr( ENOL );
+						break;
+					}
+					//fall-through
+				default:
+					setIberr( EDVR );
+					setIbcnt( errno );
+					break;
+			}
+		}
+	}
+
+	if( cmd->command )
+		conf->end = 0;
+	else if( cmd->write )
+		conf->end = cmd->end && ( cmd->completed_transfer_count == cmd->requested_transfer_count );
+	else
+		conf->end = cmd->end != 0;
+}
+
+/* Does a complete read or write with a single IBXFER ioctl, and sets ibsta
+ * from the status the driver reports at the end of the transfer.
+ * The driver locks the board for the duration of the transfer unless
+ * we are already holding the lock.  If address is not NOADDR,
+ * the device at address is addressed before the transfer. */
+static int general_xfer( ibConf_t *conf, Addr4882_t address, int write, void *buffer,
+	size_t count, int eos, int eos_flags, int send_eoi, size_t *bytes_transferred )
+{
+	ibBoard_t *board;
+	xfer_ioctl_t cmd;
+	int status;
+	int retval;
+
+	board = interfaceBoard( conf );
+
+	init_xfer_cmd( conf, &cmd, address, write, buffer, count, eos, eos_flags, send_eoi );
+
+	conf->end = 0;
+
+	retval = ioctl( board->fileno, IBXFER, &cmd );
+	finish_xfer( conf, &cmd, retval );
+
+	*bytes_transferred = cmd.completed_transfer_count;
+
+	status = cmd.ibsta;
+	fixup_status_bits( conf, &status );
+	status &= ~( ERR | TIMO | END );
+	if( retval < 0 )
+		status |= ERR;
+	if( conf->timed_out )
+		status |= TIMO;
+	if( conf->end )
+		status |= END;
+	setIbsta( status );
+
+	return retval;
+}
+
+int xfer_read( ibConf_t *conf, Addr4882_t address, void *buffer, size_t count,
+	int eos, int eos_flags, size_t *bytes_read )
+{
+	return general_xfer( conf, address, 0, buffer, count, eos, eos_flags, 0, bytes_read );
+}
+
+int xfer_write( ibConf_t *conf, Addr4882_t address, const void *buffer, size_t count,
+	int send_eoi, size_t *bytes_written )
+{
+	return general_xfer( conf, address, 1, (void*)buffer, count, 0, 0, send_eoi, bytes_written );
+}
+
 int ibstatus( ibConf_t *conf, int error, int clear_mask, int set_mask )
 {
 	int status = 0;
@@ -634,12 +773,12 @@ int is_cic( const ibBoard_t *board )
 	return 0;
 }
 
-int is_system_controller( const ibBoard_t *board )
+int is_system_controller( ibBoard_t *board )
 {
 	int retval;
 	board_info_ioctl_t info;
 
-	retval = ioctl( board->fileno, IBBOARD_INFO, &info );
+	retval = query_board_info( board, &info );
 	if( retval < 0 )
 	{
 		fprintf( stderr, "libgpib: error in is_system_controller()!\n");